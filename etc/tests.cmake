@@ -6,10 +6,15 @@ add_test(NAME t_wrapping_ints_cmp         COMMAND wrapping_integers_cmp)
 add_test(NAME t_wrapping_ints_unwrap      COMMAND wrapping_integers_unwrap)
 add_test(NAME t_wrapping_ints_wrap        COMMAND wrapping_integers_wrap)
 add_test(NAME t_wrapping_ints_roundtrip   COMMAND wrapping_integers_roundtrip)
+add_test(NAME t_wrapping_ints_unwrap_equiv COMMAND wrapping_integers_unwrap_equivalence)
+add_test(NAME t_wrapping_ints_constexpr   COMMAND wrapping_integers_constexpr)
 
 add_test(NAME t_recv_connect         COMMAND recv_connect)
 add_test(NAME t_recv_transmit        COMMAND recv_transmit)
 add_test(NAME t_recv_window          COMMAND recv_window)
+add_test(NAME t_recv_window_scale    COMMAND recv_window_scale)
+add_test(NAME t_recv_sack            COMMAND recv_sack)
+add_test(NAME t_recv_batch           COMMAND recv_batch)
 add_test(NAME t_recv_reorder         COMMAND recv_reorder)
 add_test(NAME t_recv_close           COMMAND recv_close)
 add_test(NAME t_recv_special         COMMAND recv_special)
@@ -29,12 +34,26 @@ add_test(NAME t_strm_reassem_many        COMMAND fsm_stream_reassembler_many)
 add_test(NAME t_strm_reassem_overlapping COMMAND fsm_stream_reassembler_overlapping)
 add_test(NAME t_strm_reassem_win         COMMAND fsm_stream_reassembler_win)
 add_test(NAME t_strm_reassem_cap         COMMAND fsm_stream_reassembler_cap)
+add_test(NAME t_strm_reassem_sack        COMMAND fsm_stream_reassembler_sack)
+add_test(NAME t_strm_reassem_pages       COMMAND fsm_stream_reassembler_pages)
 
 add_test(NAME t_byte_stream_construction COMMAND byte_stream_construction)
 add_test(NAME t_byte_stream_one_write    COMMAND byte_stream_one_write)
 add_test(NAME t_byte_stream_two_writes   COMMAND byte_stream_two_writes)
 add_test(NAME t_byte_stream_capacity     COMMAND byte_stream_capacity)
 add_test(NAME t_byte_stream_many_writes  COMMAND byte_stream_many_writes)
+add_test(NAME t_byte_stream_chunks       COMMAND byte_stream_chunks)
+add_test(NAME t_byte_stream_allocator    COMMAND byte_stream_allocator)
+
+add_test(NAME t_internet_checksum_fuzz   COMMAND internet_checksum_fuzz)
+add_test(NAME t_tcp_segment_rewrite     COMMAND tcp_segment_rewrite)
+add_test(NAME t_tcp_segment_serialize_into COMMAND tcp_segment_serialize_into)
+add_test(NAME t_tcp_header_parse        COMMAND tcp_header_parse)
+add_test(NAME t_tcp_options             COMMAND tcp_options)
+
+add_test(NAME t_eventloop_backends   COMMAND eventloop_backends)
+add_test(NAME t_timer_wheel          COMMAND timer_wheel)
+add_test(NAME t_eventloop_group       COMMAND eventloop_group)
 
 add_test(NAME t_webget               COMMAND "${PROJECT_SOURCE_DIR}/tests/webget_t.sh")
 
@@ -235,3 +254,15 @@ add_custom_target (check COMMAND "${PROJECT_SOURCE_DIR}/tun.sh" check 144 145
                          COMMAND "${PROJECT_SOURCE_DIR}/tap.sh" check 10
                          COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --timeout 10 -R '^t_|^arp_|^router_'
                          COMMENT "Testing libsponge...")
+
+add_custom_target (benchmark COMMAND byte_stream_benchmark
+                             COMMAND ring_index_benchmark
+                             COMMAND stream_reassembler_benchmark
+                             COMMAND internet_checksum_benchmark
+                             COMMAND stream_churn_benchmark
+                             COMMAND recv_batch_benchmark
+                             COMMAND eventloop_benchmark
+                             COMMAND timer_wheel_benchmark
+                             COMMAND eventloop_group_benchmark
+                             COMMAND tcp_parser "${PROJECT_SOURCE_DIR}/tests/ipv4_parser.data" --benchmark
+                             COMMENT "Running benchmarks...")
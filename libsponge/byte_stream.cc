@@ -1,5 +1,11 @@
 #include "byte_stream.hh"
 
+#include "util.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
 // Dummy implementation of a flow-controlled in-memory byte stream.
 
 // For Lab 0, please replace with a real implementation that passes the
@@ -10,42 +16,156 @@
 template <typename... Targs>
 void DUMMY_CODE(Targs &&... /* unused */) {}
 
-ByteStream::ByteStream(const size_t bytes) : buffer{std::vector<char>(bytes)}, capacity{bytes} {}
+ByteStream::ByteStream(const size_t bytes, const bool power_of_two_storage, Allocator &allocator_)
+    : allocator{&allocator_}
+    , buffer_length{power_of_two_storage ? round_up_to_power_of_two(bytes) : bytes}
+    , capacity{bytes}
+    , index_mask{power_of_two_storage && bytes > 1 ? this->buffer_length - 1 : 0} {}
+
+ByteStream::ByteStream(ByteStream &&other) noexcept
+    : _error{other._error}
+    , stream_ended{other.stream_ended}
+    , allocator{other.allocator}
+    , buffer{std::exchange(other.buffer, nullptr)}
+    , buffer_length{other.buffer_length}
+    , capacity{other.capacity}
+    , index_mask{other.index_mask}
+    , size{std::exchange(other.size, 0)}
+    , start{std::exchange(other.start, 0)}
+    , chunks{std::move(other.chunks)}
+    , chunk_bytes{std::exchange(other.chunk_bytes, 0)}
+    , _bytes_written{other._bytes_written}
+    , _bytes_read{other._bytes_read} {
+    other.chunks = BufferList();
+}
+
+ByteStream &ByteStream::operator=(ByteStream &&other) noexcept {
+    if (this != &other) {
+        this->release_ring();
+        this->_error = other._error;
+        this->stream_ended = other.stream_ended;
+        this->allocator = other.allocator;
+        this->buffer = std::exchange(other.buffer, nullptr);
+        this->buffer_length = other.buffer_length;
+        this->capacity = other.capacity;
+        this->index_mask = other.index_mask;
+        this->size = std::exchange(other.size, 0);
+        this->start = std::exchange(other.start, 0);
+        this->chunks = std::move(other.chunks);
+        this->chunk_bytes = std::exchange(other.chunk_bytes, 0);
+        this->_bytes_written = other._bytes_written;
+        this->_bytes_read = other._bytes_read;
+        other.chunks = BufferList();
+    }
+    return *this;
+}
+
+void ByteStream::release_ring() {
+    if (this->buffer) {
+        this->allocator->deallocate(this->buffer, this->buffer_length);
+        this->buffer = nullptr;
+    }
+}
 
-size_t ByteStream::write(const std::string &data) {
+size_t ByteStream::write(std::string_view data) {
     // if the stream has ended or the buffer is full, no more bytes can be written
     if (this->input_ended() || this->remaining_capacity() == 0)
         return 0;
 
-    size_t written = 0;
-    for (auto source = data.begin(); source != data.end() && this->remaining_capacity();
-         ++source, ++this->size, ++written) {
-        size_t destination = this->wrap_index(this->start + this->buffer_size());
-        this->buffer[destination] = *source;
-    }
+    /*
+     * The free region of the ring starts right after the last byte in the ring
+     * and may wrap around the physical end of the buffer, so the accepted bytes
+     * are copied in at most two contiguous pieces. Bytes in the ring always
+     * come after any referenced chunks, so appending here keeps them in order.
+     */
+    size_t written = std::min(data.length(), this->remaining_capacity());
+    if (written == 0)
+        return 0;
+    if (!this->buffer)
+        this->buffer = this->allocator->allocate(this->buffer_length);
+    size_t destination = this->wrap_index(this->start + this->size);
+    size_t first_piece = std::min(written, this->buffer_length - destination);
+    std::memcpy(this->buffer + destination, data.data(), first_piece);
+    std::memcpy(this->buffer, data.data() + first_piece, written - first_piece);
+
+    this->size += written;
     this->_bytes_written += written;
     return written;
 }
 
-std::string ByteStream::peek_output(const size_t len) const {
+size_t ByteStream::write(const Buffer &data) {
+    /*
+     * A Buffer can only be kept by reference if it fits entirely and the ring
+     * is empty, since referenced chunks must all come before the ring's bytes.
+     * Otherwise, copy as much of it as fits into the ring.
+     */
+    if (this->input_ended() || this->size != 0 || data.size() == 0 || data.size() > this->remaining_capacity())
+        return this->write(data.str());
+
+    this->chunks.append(data);
+    this->chunk_bytes += data.size();
+    this->_bytes_written += data.size();
+    return data.size();
+}
+
+std::string ByteStream::peek_ring(const size_t len) const {
+    // the bytes in the ring may wrap around the physical end of the buffer
+    size_t peeked = std::min(len, this->size);
+    size_t first_piece = std::min(peeked, this->buffer_length - this->start);
+
     std::string data;
+    data.reserve(peeked);
+    data.append(this->buffer + this->start, first_piece);
+    data.append(this->buffer, peeked - first_piece);
+    return data;
+}
 
-    // if the buffer is empty, no more bytes can be read
-    if (this->buffer_empty())
-        return data;
+std::string ByteStream::peek_output(const size_t len) const {
+    if (this->chunk_bytes == 0)
+        return this->peek_ring(len);
 
-    for (size_t _bytes_peeked = 0, remaining_size = this->buffer_size(); remaining_size && _bytes_peeked < len;
-         --remaining_size, ++_bytes_peeked) {
-        size_t index = this->wrap_index(this->start + _bytes_peeked);
-        data.append(1, this->buffer[index]);
+    size_t remaining = std::min(len, this->buffer_size());
+    std::string data;
+    data.reserve(remaining);
+    for (auto chunk = this->chunks.buffers().begin(); remaining && chunk != this->chunks.buffers().end(); ++chunk) {
+        std::string_view view = chunk->str().substr(0, remaining);
+        data.append(view);
+        remaining -= view.size();
     }
+    data.append(this->peek_ring(remaining));
     return data;
 }
 
+BufferViewList ByteStream::peek_views(const size_t len) const {
+    size_t remaining = std::min(len, this->buffer_size());
+    BufferViewList views;
+
+    // referenced chunks come first
+    for (auto chunk = this->chunks.buffers().begin(); remaining && chunk != this->chunks.buffers().end(); ++chunk) {
+        std::string_view view = chunk->str().substr(0, remaining);
+        views.append(view);
+        remaining -= view.size();
+    }
+
+    // then the ring, whose bytes may wrap around the physical end of the buffer
+    size_t first_piece = std::min(remaining, this->buffer_length - this->start);
+    views.append({this->buffer + this->start, first_piece});
+    views.append({this->buffer, remaining - first_piece});
+    return views;
+}
+
 void ByteStream::pop_output(const size_t len) {
-    this->_bytes_read += len <= this->buffer_size() ? len : this->buffer_size();
-    this->size = len <= this->buffer_size() ? this->size - len : 0;
-    this->start = this->wrap_index(this->start + len);
+    size_t popped = std::min(len, this->buffer_size());
+    this->_bytes_read += popped;
+
+    // referenced chunks are consumed first, then the ring
+    size_t popped_chunks = std::min(popped, this->chunk_bytes);
+    this->chunks.remove_prefix(popped_chunks);
+    this->chunk_bytes -= popped_chunks;
+
+    size_t popped_ring = popped - popped_chunks;
+    this->size -= popped_ring;
+    this->start = this->wrap_index(this->start + popped_ring);
 }
 
 std::string ByteStream::read(const size_t len) {
@@ -54,7 +174,28 @@ std::string ByteStream::read(const size_t len) {
     return data;
 }
 
-size_t ByteStream::buffer_size() const { return this->size; }
+BufferList ByteStream::read_buffers(const size_t len) {
+    size_t remaining = std::min(len, this->buffer_size());
+    BufferList data;
+
+    // hand out slices of the referenced chunks without copying them
+    for (auto chunk = this->chunks.buffers().begin(); remaining && chunk != this->chunks.buffers().end(); ++chunk) {
+        Buffer slice = *chunk;
+        if (slice.size() > remaining)
+            slice.remove_suffix(slice.size() - remaining);
+        remaining -= slice.size();
+        data.append(slice);
+    }
+
+    // bytes from the ring have to be copied out
+    if (remaining)
+        data.append(this->peek_ring(remaining));
+
+    this->pop_output(len);
+    return data;
+}
+
+size_t ByteStream::buffer_size() const { return this->chunk_bytes + this->size; }
 
 bool ByteStream::buffer_empty() const { return this->buffer_size() == 0; }
 
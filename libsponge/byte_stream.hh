@@ -1,14 +1,37 @@
 #ifndef SPONGE_LIBSPONGE_BYTE_STREAM_HH
 #define SPONGE_LIBSPONGE_BYTE_STREAM_HH
 
+#include "buffer.hh"
+#include "page_pool.hh"
+
 #include <string>
-#include <vector>
+#include <string_view>
 
 //! \brief An in-order byte stream.
 
 //! Bytes are written on the "input" side and read from the "output"
 //! side.  The byte stream is finite: the writer can end the input,
 //! and then no more bytes can be written.
+//!
+//! The reader can either copy bytes out with peek_output() and read(), or
+//! look at them in place with peek_views() and consume them with pop_output(),
+//! e.g. to hand the buffered bytes straight to [writev(2)](\ref man2::writev):
+//!
+//! ~~~{.cc}
+//! stream.pop_output(fd.write(stream.peek_views(stream.buffer_size()), false));
+//! ~~~
+//!
+//! Bytes written as a std::string or std::string_view are copied into a ring
+//! buffer. A Buffer written while the ring is empty is instead kept by
+//! reference (as a chunk of a BufferList), and read_buffers() hands chunks back
+//! out as Buffer slices, so a large payload can pass through the stream
+//! without being copied. Capacity is accounted byte-for-byte either way.
+//!
+//! The ring storage comes from an Allocator (by default the heap) when bytes
+//! are first copied in, so a stream that only ever passes Buffers along by
+//! reference holds no storage, and goes back when the stream is destroyed.
+//! Passing PagePool::local() recycles storage across short-lived streams, but
+//! then the stream must be destroyed on the thread that built it.
 class ByteStream {
   private:
     // Your code here -- add private members as necessary.
@@ -21,19 +44,54 @@ class ByteStream {
     bool _error{};        //!< Flag indicating that the stream suffered an error.
     bool stream_ended{};  //!< Flag indicating that the stream has ended.
 
-    std::vector<char> buffer;
-    size_t capacity;
-    size_t size = 0;   //!< Size of the in-transit sequence.
-    size_t start = 0;  //!< Index of the first byte of the in-transit sequence.
+    Allocator *allocator;    //!< Where the ring storage comes from.
+    char *buffer{nullptr};   //!< The ring storage, or nullptr until bytes are first copied in.
+    size_t buffer_length;    //!< The size of the ring storage, which may be larger than `capacity`.
+    size_t capacity;         //!< The number of bytes the stream can hold.
+    size_t index_mask;       //!< `buffer_length - 1` if the ring is indexed by masking, otherwise 0.
+    size_t size = 0;         //!< Size of the in-transit sequence in the ring.
+    size_t start = 0;        //!< Index of the first byte of the in-transit sequence in the ring.
+
+    BufferList chunks{};    //!< Buffers held by reference, which precede the bytes in the ring.
+    size_t chunk_bytes{0};  //!< Total size of `chunks`.
 
     size_t _bytes_written = 0;
     size_t _bytes_read = 0;
 
-    size_t wrap_index(const size_t index) const { return this->capacity == 0 ? 0 : index % this->capacity; }
+    //! Copy the first `len` bytes of the ring.
+    std::string peek_ring(const size_t len) const;
+
+    //! Give the ring storage back to the allocator, if it is held.
+    void release_ring();
+
+    size_t wrap_index(const size_t index) const {
+        if (this->index_mask)
+            return index & this->index_mask;
+        return this->buffer_length == 0 ? 0 : index % this->buffer_length;
+    }
 
   public:
     //! Construct a stream with room for `capacity` bytes.
-    ByteStream(const size_t capacity);
+    //! \param capacity is the number of bytes the stream accepts
+    //! \param power_of_two_storage rounds the ring storage up to a power of two
+    //! so that positions wrap with a mask instead of a division; the stream
+    //! still accepts exactly `capacity` bytes
+    //! \param allocator is where the ring storage comes from
+    ByteStream(const size_t capacity,
+               const bool power_of_two_storage = false,
+               Allocator &allocator = HeapAllocator::instance());
+
+    //! Give the ring storage back.
+    ~ByteStream() { this->release_ring(); }
+
+    ByteStream(const ByteStream &) = delete;
+    ByteStream &operator=(const ByteStream &) = delete;
+
+    //! Take over the bytes of `other`, which is left empty.
+    ByteStream(ByteStream &&other) noexcept;
+
+    //! Give the ring storage back, and take over the bytes of `other`, which is left empty.
+    ByteStream &operator=(ByteStream &&other) noexcept;
 
     //! \name "Input" interface for the writer
     //!@{
@@ -41,7 +99,18 @@ class ByteStream {
     //! Write a string of bytes into the stream. Write as many
     //! as will fit, and return how many were written.
     //! \returns the number of bytes accepted into the stream
-    size_t write(const std::string &data);
+    size_t write(std::string_view data);
+
+    //! Write a string of bytes into the stream. Write as many
+    //! as will fit, and return how many were written.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(const std::string &data) { return write(std::string_view(data)); }
+
+    //! Write a Buffer into the stream, keeping a reference to it instead of
+    //! copying it if it fits entirely and no copied bytes are waiting to be read.
+    //! Otherwise, copy as many bytes as will fit.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(const Buffer &data);
 
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
@@ -60,6 +129,12 @@ class ByteStream {
     //! \returns a string
     std::string peek_output(const size_t len) const;
 
+    //! Peek at next "len" bytes of the stream without copying them
+    //! \returns views into the stream's storage (one per referenced chunk, plus
+    //! at most two into the ring), which stay valid until the next call to
+    //! write() or pop_output()
+    BufferViewList peek_views(const size_t len) const;
+
     //! Remove bytes from the buffer
     void pop_output(const size_t len);
 
@@ -67,6 +142,10 @@ class ByteStream {
     //! \returns a string
     std::string read(const size_t len);
 
+    //! Read (i.e., take and then pop) the next "len" bytes of the stream as Buffers
+    //! \returns slices of the referenced chunks, followed by a copy of any bytes from the ring
+    BufferList read_buffers(const size_t len);
+
     //! \returns `true` if the stream input has ended
     bool input_ended() const { return this->stream_ended; }
 
@@ -1,5 +1,9 @@
 #include "stream_reassembler.hh"
 
+#include "util.hh"
+
+#include <algorithm>
+
 // Dummy implementation of a stream reassembler.
 
 // For Lab 1, please replace with a real implementation that passes the
@@ -10,26 +14,22 @@
 template <typename... Targs>
 void DUMMY_CODE(Targs &&... /* unused */) {}
 
-StreamReassembler::StreamReassembler(const std::size_t capacity)
+StreamReassembler::StreamReassembler(const std::size_t capacity,
+                                     const bool power_of_two_storage,
+                                     const Backend backend,
+                                     Allocator &allocator)
     :  // the comma operator evaluates the operands from left to right, and the
        // value on the right is used for assignment
     capacity_stream{capacity}
     , capacity_window{capacity}
-    , _output{ByteStream(this->capacity_stream)}
-    , window{std::vector<char>(this->capacity_window)}
-    , received{std::vector<bool>(this->capacity_window)} {
-    for (auto iterator = this->received.begin(); iterator != this->received.end(); ++iterator)
-        *iterator = false;
-}
-
-std::size_t StreamReassembler::stream_to_window_index(const std::uint64_t index) const {
-    if (this->capacity_window == 0)
-        return 0;
-    else
-        return std::size_t(index % this->capacity_window);
+    , _output{ByteStream(this->capacity_stream, power_of_two_storage, allocator)}
+    , window{this->capacity_window, power_of_two_storage, allocator}
+    , received{IntervalSet()} {
+    if (backend == Backend::Bitmap)
+        this->received = BitmapSet(this->capacity_window, allocator);
 }
 
-std::size_t StreamReassembler::try_push_substring(const std::string &data, const std::uint64_t index) {
+std::size_t StreamReassembler::try_push_substring(std::string_view data, const std::uint64_t index) {
     std::uint64_t string_first = index;
     std::uint64_t string_last = string_first + data.length() - 1;
     std::uint64_t window_first = this->index_stream;
@@ -50,29 +50,28 @@ std::size_t StreamReassembler::try_push_substring(const std::string &data, const
      */
     std::uint64_t overlap_first = string_first >= window_first ? string_first : window_first;
     std::uint64_t overlap_last = string_last <= window_last ? string_last : window_last;
+    std::size_t overlap_length = std::size_t(overlap_last - overlap_first + 1);
 
-    // copy the overlapped bytes from string into the window
-    for (std::uint64_t stream_index = overlap_first; stream_index <= overlap_last; ++stream_index) {
-        std::size_t string_index = std::size_t(stream_index - string_first);
-        std::size_t window_index = this->stream_to_window_index(stream_index);
-        this->window[window_index] = data[string_index];
-        this->received[window_index] = true;
-    }
+    // copy the overlapped bytes from string into the window, which brings in the pages they land on
+    this->window.write(overlap_first, data.substr(overlap_first - string_first, overlap_length));
+
+    std::visit([&](auto &set) { set.insert(overlap_first, overlap_last + 1); }, this->received);
+
+    // the contiguous bytes only grow if the substring filled the first missing byte
+    if (overlap_first <= this->index_missing && overlap_last >= this->index_missing)
+        this->extend_contiguous(this->index_missing);
+
+    // if the substring still isn't contiguous, it arrived out of order
+    if (overlap_last >= this->index_missing)
+        this->record_recent(overlap_last);
 
-    return std::size_t(overlap_last - overlap_first + 1);
+    return overlap_length;
 }
 
-std::size_t StreamReassembler::contiguous_bytes() const {
-    // count the number of contiguous bytes in the window
-    std::size_t bytes = 0;
-    for (std::size_t offset = 0; offset < this->capacity_window; ++offset) {
-        std::size_t window_index = this->stream_to_window_index(std::uint64_t(this->index_stream + offset));
-        if (this->received[window_index])
-            ++bytes;
-        else
-            break;
-    }
-    return bytes;
+void StreamReassembler::extend_contiguous(const std::uint64_t index) {
+    // the contiguous bytes are the received interval that starts at the beginning of the window
+    this->index_missing = std::visit([&](const auto &set) { return set.contiguous_end(index); }, this->received);
+    this->prune_recent();
 }
 
 std::size_t StreamReassembler::assemble() {
@@ -82,33 +81,51 @@ std::size_t StreamReassembler::assemble() {
         return 0;
 
     /*
-     * Extract the contiguous bytes as a string. We need to start at the logical
-     * first byte of the window, not simply at the physical first byte of the
-     * window, and copy each chart into the string. As the copying proceeds, we
-     * may wrap around to the physical beginning of the window, so we cannot use
-     * iterator to initialize the string.
+     * Write the contiguous bytes straight from the window into the output
+     * stream. They start at the logical first byte of the window and may span
+     * several pages, so they are written a page at a time, until the output
+     * stream is full.
      */
-    std::string data;
-    for (std::size_t offset = 0; offset < contiguous_length; ++offset) {
-        std::size_t window_index = this->stream_to_window_index(std::uint64_t(this->index_stream + offset));
-        data.append(1, this->window[window_index]);
+    std::size_t bytes_written = 0;
+    while (bytes_written < contiguous_length) {
+        std::string_view piece =
+            this->window.read(this->index_stream + bytes_written, contiguous_length - bytes_written);
+        std::size_t piece_written = this->_output.write(piece);
+        bytes_written += piece_written;
+        if (piece_written < piece.length())
+            break;
     }
 
-    // write as much contiguous bytes as possible into the output stream
-    std::size_t bytes_written = this->_output.write(data);
+    this->slide_window(bytes_written);
+    return bytes_written;
+}
 
-    // update object state, including the "received" flags and "index_stream"
-    for (std::size_t offset = 0; offset < bytes_written; ++offset) {
-        std::size_t window_index = this->stream_to_window_index(std::uint64_t(this->index_stream + offset));
-        this->received[window_index] = false;
-    }
+void StreamReassembler::slide_window(const std::size_t bytes_written) {
+    // update object state, including the received bytes and "index_stream"
     this->index_stream += bytes_written;
+    std::visit([&](auto &set) { set.erase_below(this->index_stream); }, this->received);
 
-    return bytes_written;
+    // hand back the pages the window has slid past, or all of them once nothing is left to assemble
+    if (this->empty())
+        this->window.release_all();
+    else
+        this->window.release_below(this->index_stream);
+
+    // bytes written straight from a substring may have overtaken the contiguous bytes in the window
+    if (this->index_missing < this->index_stream)
+        this->extend_contiguous(this->index_stream);
 }
 
-void StreamReassembler::push_substring(const std::string &data, const std::size_t index, const bool eof) {
-    // try to push substring and assemble
+void StreamReassembler::push_substring(std::string_view data, const std::uint64_t index, const bool eof) {
+    /*
+     * If the substring reaches the beginning of the window, the bytes from
+     * there on are the next ones the output stream expects, so write them into
+     * the stream directly instead of staging them in the window.
+     */
+    if (index <= this->index_stream && index + data.length() > this->index_stream)
+        this->slide_window(this->_output.write(data.substr(this->index_stream - index)));
+
+    // push whatever the stream couldn't take (or the out-of-order substring) into the window, and assemble
     if (data.length())
         this->try_push_substring(data, index);
     this->assemble();
@@ -117,27 +134,86 @@ void StreamReassembler::push_substring(const std::string &data, const std::size_
     if (eof)
         this->index_eof = index + data.length();
     // if the entire stream has been received, terminate the output stream
-    if (this->index_eof == this->index_stream + this->contiguous_bytes())
+    if (this->index_eof == this->index_missing)
         this->_output.end_input();
 }
 
-std::size_t StreamReassembler::unassembled_bytes() const {
-    // count the number of bytes that exist in the window
-    std::size_t bytes = 0;
-    for (std::size_t offset = 0; offset < this->capacity_window; ++offset) {
-        std::size_t window_index = this->stream_to_window_index(std::uint64_t(this->index_stream + offset));
-        if (this->received[window_index])
-            ++bytes;
+void StreamReassembler::push_substring(const Buffer &data, const std::uint64_t index, const bool eof) {
+    // hand the bytes that the output stream expects next over as a slice of the Buffer
+    if (index <= this->index_stream && index + data.size() > this->index_stream) {
+        Buffer in_order = data;
+        in_order.remove_prefix(this->index_stream - index);
+        this->slide_window(this->_output.write(in_order));
     }
-    return bytes;
+
+    // the rest is handled like any other substring
+    this->push_substring(data.str(), index, eof);
+}
+
+std::size_t StreamReassembler::unassembled_bytes() const {
+    return std::visit([](const auto &set) { return set.size(); }, this->received);
 }
 
 bool StreamReassembler::empty() const {
-    // if any byte exists in the window, return false; otherwise, return true
-    for (std::size_t offset = 0; offset < this->capacity_window; ++offset) {
-        std::size_t window_index = this->stream_to_window_index(std::uint64_t(this->index_stream + offset));
-        if (this->received[window_index])
-            return false;
+    return std::visit([](const auto &set) { return set.empty(); }, this->received);
+}
+
+void StreamReassembler::prune_recent() {
+    /*
+     * Drop the substrings that have been assembled (or made contiguous), and
+     * those whose range has merged into that of a more recent one, so they
+     * don't take the place of older ranges that are still unassembled.
+     */
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < this->recent_count; i++) {
+        const std::uint64_t index = this->recent_indices[i];
+        if (index < this->index_missing)
+            continue;
+
+        const Range range = std::visit([&](const auto &set) { return set.interval_containing(index); }, this->received);
+        const auto in_range = [&](const std::uint64_t other) { return other >= range.first && other < range.second; };
+        if (std::none_of(this->recent_indices.begin(), this->recent_indices.begin() + kept, in_range))
+            this->recent_indices[kept++] = index;
+    }
+    this->recent_count = kept;
+}
+
+void StreamReassembler::record_recent(const std::uint64_t last) {
+    this->prune_recent();
+
+    /*
+     * Older substrings in the same range as this one (e.g. the earlier segments
+     * of a burst that arrived after a loss) would only repeat its range, so they
+     * are dropped rather than pushing the older ranges out.
+     */
+    const Range range = std::visit([&](const auto &set) { return set.interval_containing(last); }, this->received);
+    const auto in_range = [&](const std::uint64_t index) { return index >= range.first && index < range.second; };
+    const auto end =
+        std::remove_if(this->recent_indices.begin(), this->recent_indices.begin() + this->recent_count, in_range);
+    this->recent_count = end - this->recent_indices.begin();
+
+    // move the older indices down a place, dropping the oldest if there's no room
+    this->recent_count = std::min(this->recent_count + 1, MAX_RECENT_RANGES);
+    std::copy_backward(this->recent_indices.begin(),
+                       this->recent_indices.begin() + this->recent_count - 1,
+                       this->recent_indices.begin() + this->recent_count);
+    this->recent_indices[0] = last;
+}
+
+std::size_t StreamReassembler::recent_ranges(std::array<Range, MAX_RECENT_RANGES> &ranges,
+                                             const std::size_t max_ranges) const {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < this->recent_count && count < std::min(max_ranges, MAX_RECENT_RANGES); i++) {
+        // skip the substrings that have been assembled (or made contiguous) since they arrived
+        const std::uint64_t index = this->recent_indices[i];
+        if (index < this->index_missing)
+            continue;
+
+        // report each range once, even if several recent substrings landed in it
+        const Range range =
+            std::visit([&](const auto &set) { return set.interval_containing(index); }, this->received);
+        if (std::find(ranges.begin(), ranges.begin() + count, range) == ranges.begin() + count)
+            ranges[count++] = range;
     }
-    return true;
+    return count;
 }
@@ -1,36 +1,69 @@
 #ifndef SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
 #define SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
 
+#include "bitmap_set.hh"
 #include "byte_stream.hh"
+#include "interval_set.hh"
+#include "paged_window.hh"
 
+#include <array>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
 #include <vector>
 
 /**
  * @brief A class that assembles byte sequences into an in-order byte stream.
  */
 class StreamReassembler {
+  public:
+    /**
+     * @brief How the reassembler records which bytes of the window it holds.
+     */
+    enum class Backend {
+        Intervals,  //!< A sorted set of received intervals (IntervalSet); cheap when there are few holes.
+        Bitmap      //!< One bit per window byte, scanned a word at a time (BitmapSet); cost is bounded by the window.
+    };
+
+    //! A range of stream indices, [first, second)
+    using Range = std::pair<std::uint64_t, std::uint64_t>;
+
+    //! The most ranges that recent_ranges() reports (as many as there are SACK blocks in a TCP header)
+    static constexpr std::size_t MAX_RECENT_RANGES = 4;
+
   private:
     std::size_t capacity_stream;  // The max number of bytes in the output stream
     std::size_t capacity_window;  // The max number of bytes in the buffer window
 
-    ByteStream _output;          // The output stream
-    std::vector<char> window;    // The buffer window
-    std::vector<bool> received;  // Flags noting which window bytes are received
+    ByteStream _output;  // The output stream
+    PagedWindow window;  // The buffer window, which only holds pages while it holds unassembled bytes
+    std::variant<IntervalSet, BitmapSet> received;  // The stream indices of the bytes received into the window
 
     std::uint64_t index_stream{0};               // The stream index of the first byte in the window
+    std::uint64_t index_missing{0};              // The stream index of the first byte not received yet
     std::uint64_t index_eof{~std::uint64_t(0)};  // The stream index of the eof, one past the last byte
 
+    // The last stream index of each of the most recent substrings that arrived out of order, the most
+    // recent first, and how many there are
+    std::array<std::uint64_t, MAX_RECENT_RANGES> recent_indices{};
+    std::size_t recent_count{0};
+
     /**
-     * @brief Converts a stream index into a window index.
+     * @brief Remember that a substring arrived out of order just now.
      *
-     * @param index The stream index.
-     * @return std::uint64_t The window index.
+     * @param last The stream index of the substring's last byte.
+     */
+    void record_recent(const std::uint64_t last);
+
+    /**
+     * @brief Forget the recent substrings that have been assembled, or whose
+     * range now holds a more recent one.
      */
-    std::size_t stream_to_window_index(const std::uint64_t index) const;
+    void prune_recent();
 
     /**
      * @brief Try to push the string `data`, which starts at `index` in the
@@ -42,19 +75,39 @@ class StreamReassembler {
      * @return std::size_t The number of contiguous bytes (can start from anywhere
      * in `data`) that was successfully pushed into the window.
      */
-    std::size_t try_push_substring(const std::string &data, const std::uint64_t index);
+    std::size_t try_push_substring(std::string_view data, const std::uint64_t index);
 
     /**
      * @brief Returns the number of contiguous bytes in the window, starting from
      * the beginning of the window.
+     * @note This is kept up to date incrementally (see index_missing), so it
+     * takes constant time.
      *
      * @return std::size_t The number of contiguous bytes.
      */
-    std::size_t contiguous_bytes() const;
+    std::size_t contiguous_bytes() const { return std::size_t(this->index_missing - this->index_stream); }
+
+    /**
+     * @brief Recompute index_missing by following the run of received bytes
+     * that starts at `index`, which must itself be received or be index_stream.
+     *
+     * @param index Where the run of received bytes starts.
+     */
+    void extend_contiguous(const std::uint64_t index);
+
+    /**
+     * @brief Slide the window forward past bytes that were just written into
+     * the output stream, and forget any of them that were in the window.
+     *
+     * @param bytes_written The number of bytes written into the output stream.
+     */
+    void slide_window(const std::size_t bytes_written);
 
     /**
      * @brief Assemble the unassenbled bytes in the window, and write as many as
      * possible into the output stream.
+     * @note The cost is proportional to the number of bytes written, not to the
+     * size of the window.
      *
      * @return std::size_t The number of bytes written into the output stream.
      */
@@ -64,12 +117,39 @@ class StreamReassembler {
     /**
      * @brief Construct a new Stream Reassembler object.
      * @note Assembled bytes are written into the output stream, and unassembled
-     * bytes are kept in the buffer window.
+     * bytes are kept in the buffer window. The window takes 4 KB pages from the
+     * allocator only while it holds unassembled bytes, so a reassembler whose
+     * bytes all arrive in order never allocates any.
      *
      * @param capacity The total number of assembled + unassembled bytes that
      * can be stored in the object.
+     * @param power_of_two_storage Whether to round the window and output stream
+     * storage up to a power of two, so that stream indices wrap with a mask
+     * instead of a division. The capacity is still enforced exactly.
+     * @param backend How to record which bytes of the window have been received.
+     * @param allocator Where the storage of the window and the output stream
+     * comes from; by default, the heap. A PagePool is faster under connection
+     * churn, but ties the reassembler to the pool's thread.
      */
-    StreamReassembler(const std::size_t capacity);
+    StreamReassembler(const std::size_t capacity,
+                      const bool power_of_two_storage = false,
+                      const Backend backend = Backend::Intervals,
+                      Allocator &allocator = HeapAllocator::instance());
+
+    /**
+     * @brief Push the string `data`, which starts at `index` in stream, into
+     * the window, then assemble and write any contiguous bytes into the output
+     * stream.
+     * @note Bytes that are next in line for the output stream are written into
+     * it directly; only the bytes that cannot be written yet are copied into
+     * the window. A Buffer (e.g. a segment payload) can be passed without
+     * copying it first.
+     *
+     * @param data A view of the substring.
+     * @param index Where `data` starts in the stream.
+     * @param eof Whether the last byte of `data` is the last byte of the stream.
+     */
+    void push_substring(std::string_view data, const std::uint64_t index, const bool eof);
 
     /**
      * @brief Push the string `data`, which starts at `index` in stream, into
@@ -80,7 +160,23 @@ class StreamReassembler {
      * @param index Where `data` starts in the stream.
      * @param eof Whether the last byte of `data` is the last byte of the stream.
      */
-    void push_substring(const std::string &data, const std::uint64_t index, const bool eof);
+    void push_substring(const std::string &data, const std::uint64_t index, const bool eof) {
+        push_substring(std::string_view(data), index, eof);
+    }
+
+    /**
+     * @brief Push the Buffer `data`, which starts at `index` in stream, into
+     * the window, then assemble and write any contiguous bytes into the output
+     * stream.
+     * @note Bytes that are next in line for the output stream are handed to it
+     * as a slice of `data`, which the stream may keep by reference instead of
+     * copying (see ByteStream::write(const Buffer &)).
+     *
+     * @param data A Buffer, e.g. a segment payload.
+     * @param index Where `data` starts in the stream.
+     * @param eof Whether the last byte of `data` is the last byte of the stream.
+     */
+    void push_substring(const Buffer &data, const std::uint64_t index, const bool eof);
 
     /**
      * @brief Return the output stream.
@@ -96,7 +192,8 @@ class StreamReassembler {
      * @brief Returns the number of unassembled bytes, i.e. the number of bytes
      * in the window.
      * @note If a byte in the stream has been pushed more than once, it should
-     * only be counted once for the purpose of this function.
+     * only be counted once for the purpose of this function. The count is
+     * maintained as bytes arrive and leave, so this takes constant time.
      *
      * @return std::size_t The number of bytes in the window.
      */
@@ -110,6 +207,21 @@ class StreamReassembler {
      * @return false If there's unassembled bytes.
      */
     bool empty() const;
+
+    /**
+     * @brief Returns the ranges of received but unassembled bytes beyond the
+     * contiguous ones, for selective acknowledgments
+     * ([RFC 2018](\ref rfc::rfc2018)).
+     * @note The range holding the most recently received out-of-order substring
+     * comes first, then the ranges of the substrings before it, most recent
+     * first, without repeats. Ranges that have since been assembled are left out.
+     *
+     * @param ranges Where up to `max_ranges` ranges are stored.
+     * @param max_ranges The most ranges to store, at most MAX_RECENT_RANGES.
+     * @return std::size_t The number of ranges stored.
+     */
+    std::size_t recent_ranges(std::array<Range, MAX_RECENT_RANGES> &ranges,
+                              const std::size_t max_ranges = MAX_RECENT_RANGES) const;
 };
 
 #endif  // SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
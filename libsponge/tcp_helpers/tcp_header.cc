@@ -1,6 +1,12 @@
 #include "tcp_header.hh"
 
+#include "util.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <sstream>
+#include <stdexcept>
 
 using namespace std;
 
@@ -14,7 +20,55 @@ using namespace std;
 //! - the header's `doff` field is shorter than the minimum allowed
 //! - there is less data in the header than the `doff` field claims
 //! - the checksum is bad
+//!
+//! When the whole fixed-length header is there, its size is checked once and each field is
+//! decoded with a single (unaligned) load and byte swap. Otherwise, parse_fields() reads the
+//! header field by field, so the results (including errors) are the same either way.
 ParseResult TCPHeader::parse(NetParser &p) {
+    const string_view raw = p.unparsed();
+    if (p.error() or raw.size() < LENGTH) {
+        return parse_fields(p);
+    }
+
+    const char *const data = raw.data();
+    sport = NetParser::load_u16(data);                     // source port
+    dport = NetParser::load_u16(data + 2);                 // destination port
+    seqno = WrappingInt32{NetParser::load_u32(data + 4)};  // sequence number
+    ackno = WrappingInt32{NetParser::load_u32(data + 8)};  // ack number
+    doff = uint8_t(data[12]) >> 4;                         // data offset
+
+    const uint8_t fl_b = data[13];  // byte including flags
+    urg = static_cast<bool>(fl_b & 0b0010'0000);
+    ack = static_cast<bool>(fl_b & 0b0001'0000);
+    psh = static_cast<bool>(fl_b & 0b0000'1000);
+    rst = static_cast<bool>(fl_b & 0b0000'0100);
+    syn = static_cast<bool>(fl_b & 0b0000'0010);
+    fin = static_cast<bool>(fl_b & 0b0000'0001);
+
+    win = NetParser::load_u16(data + 14);    // window size
+    cksum = NetParser::load_u16(data + 16);  // checksum
+    uptr = NetParser::load_u16(data + 18);   // urgent pointer
+
+    // parse the options, and consume the header including them in one step
+    if (doff >= 5 and raw.size() >= size_t(4 * doff)) {
+        options.parse(raw.substr(LENGTH, 4 * doff - LENGTH));
+        p.remove_prefix(4 * doff);
+        return ParseResult::NoError;
+    }
+
+    // otherwise, fail the same way that parse_fields() does
+    options = {};
+    p.remove_prefix(LENGTH);
+    if (doff < 5) {
+        return ParseResult::HeaderTooShort;
+    }
+    p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
+    return p.get_error();
+}
+
+//! \param[in,out] p is a NetParser from which the TCP fields will be extracted
+//! \returns a ParseResult indicating success or the reason for failure
+ParseResult TCPHeader::parse_fields(NetParser &p) {
     sport = p.u16();                 // source port
     dport = p.u16();                 // destination port
     seqno = WrappingInt32{p.u32()};  // sequence number
@@ -34,11 +88,18 @@ ParseResult TCPHeader::parse(NetParser &p) {
     uptr = p.u16();   // urgent pointer
 
     if (doff < 5) {
+        options = {};
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
-    p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
+    // parse the options (if they're all there), and skip past them
+    const size_t options_length = doff * 4 - TCPHeader::LENGTH;
+    if (not p.error() and p.unparsed().size() >= options_length) {
+        options.parse(p.unparsed().substr(0, options_length));
+    } else {
+        options = {};
+    }
+    p.remove_prefix(options_length);
 
     if (p.error()) {
         return p.get_error();
@@ -54,29 +115,93 @@ string TCPHeader::serialize() const {
         throw runtime_error("TCP header too short");
     }
 
-    string ret;
-    ret.reserve(4 * doff);
+    string ret(length(), 0);
+    serialize_into(ret.data(), ret.size());
+    return ret;
+}
+
+size_t TCPHeader::length() const { return max(size_t(4 * doff), LENGTH + options.length()); }
 
-    NetUnparser::u16(ret, sport);              // source port
-    NetUnparser::u16(ret, dport);              // destination port
-    NetUnparser::u32(ret, seqno.raw_value());  // sequence number
-    NetUnparser::u32(ret, ackno.raw_value());  // ack number
-    NetUnparser::u8(ret, doff << 4);           // data offset
+//! \param[out] out is where the header (length() bytes, including options and zero padding) is written
+//! \param[in] size is the number of bytes available at `out`
+//! \details Does not recompute the checksum: the `cksum` field is written (and summed) as it is.
+//! The data offset written is large enough for the options, even if `doff` isn't.
+uint32_t TCPHeader::serialize_into(char *out, const size_t size) const {
+    // sanity check
+    const size_t header_length = length();
+    if (doff < 5) {
+        throw runtime_error("TCP header too short");
+    }
+    if (header_length > LENGTH + TCPOptions::MAX_LENGTH) {
+        throw runtime_error("TCP options too long");
+    }
+    if (size < header_length) {
+        throw runtime_error("TCPHeader::serialize_into: no room for the header");
+    }
 
     const uint8_t fl_b = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
                          (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
-    NetUnparser::u8(ret, fl_b);  // flags
-    NetUnparser::u16(ret, win);  // window size
+    // the header's 16-bit words, in order: ports, sequence number, ack number, data offset and flags,
+    // window size, checksum and urgent pointer
+    const array<uint16_t, LENGTH / 2> words{sport,
+                                            dport,
+                                            uint16_t(seqno.raw_value() >> 16),
+                                            uint16_t(seqno.raw_value() & 0xffff),
+                                            uint16_t(ackno.raw_value() >> 16),
+                                            uint16_t(ackno.raw_value() & 0xffff),
+                                            uint16_t(header_length / 4 << 12 | fl_b),
+                                            win,
+                                            cksum,
+                                            uptr};
+
+    // write each word in network byte order, and sum it while it's at hand
+    uint32_t sum = 0;
+    for (size_t i = 0; i < words.size(); ++i) {
+        out[2 * i] = char(words[i] >> 8);
+        out[2 * i + 1] = char(words[i] & 0xff);
+        sum += words[i];
+    }
 
-    NetUnparser::u16(ret, cksum);  // checksum
+    // then the options, padded with zeros (end-of-options) to the header length, and their sum
+    options.serialize_into(out + LENGTH);
+    const size_t options_end = LENGTH + options.length();
+    memset(out + options_end, 0, header_length - options_end);
+    for (size_t i = LENGTH; i < options_end; i += 2) {
+        sum += NetParser::load_u16(out + i);
+    }
+    return sum;
+}
+
+//! Overwrite the 16-bit field at `offset` in a serialized header, and update the checksum to match
+static void rewrite_u16(string &serialized, const size_t offset, const uint16_t value) {
+    if (serialized.size() < TCPHeader::LENGTH) {
+        throw runtime_error("TCP header too short");
+    }
 
-    NetUnparser::u16(ret, uptr);  // urgent pointer
+    char *const cksum = serialized.data() + TCPHeader::CKSUM_OFFSET;
+    const uint16_t old_value = NetParser::load_u16(serialized.data() + offset);
+    NetUnparser::store_u16(serialized.data() + offset, value);
+    NetUnparser::store_u16(cksum, InternetChecksum::update(NetParser::load_u16(cksum), old_value, value));
+}
 
-    ret.resize(4 * doff);  // expand header to advertised size
+//! \param[in,out] serialized is a header produced by serialize(), with its checksum filled in
+//! \param[in] seqno is the new sequence number
+void TCPHeader::rewrite_seqno(string &serialized, const WrappingInt32 seqno) {
+    rewrite_u16(serialized, SEQNO_OFFSET, seqno.raw_value() >> 16);
+    rewrite_u16(serialized, SEQNO_OFFSET + 2, seqno.raw_value() & 0xffff);
+}
 
-    return ret;
+//! \param[in,out] serialized is a header produced by serialize(), with its checksum filled in
+//! \param[in] ackno is the new ack number
+void TCPHeader::rewrite_ackno(string &serialized, const WrappingInt32 ackno) {
+    rewrite_u16(serialized, ACKNO_OFFSET, ackno.raw_value() >> 16);
+    rewrite_u16(serialized, ACKNO_OFFSET + 2, ackno.raw_value() & 0xffff);
 }
 
+//! \param[in,out] serialized is a header produced by serialize(), with its checksum filled in
+//! \param[in] win is the new window size
+void TCPHeader::rewrite_win(string &serialized, const uint16_t win) { rewrite_u16(serialized, WIN_OFFSET, win); }
+
 //! \returns A string with the header's contents
 string TCPHeader::to_string() const {
     stringstream ss{};
@@ -89,7 +214,8 @@ string TCPHeader::to_string() const {
        << " fin: " << fin << '\n'
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
-       << "TCP uptr: " << +uptr << '\n';
+       << "TCP uptr: " << +uptr << '\n'
+       << options.to_string();
     return ss.str();
 }
 
@@ -104,5 +230,5 @@ bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
     return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
            psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+           uptr == other.uptr && options == other.options;
 }
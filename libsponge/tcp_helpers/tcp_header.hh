@@ -2,13 +2,22 @@
 #define SPONGE_LIBSPONGE_TCP_HEADER_HH
 
 #include "parser.hh"
+#include "tcp_options.hh"
 #include "wrapping_integers.hh"
 
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
+//! \note The options in TCPOptions are supported; any others are skipped when parsing
 struct TCPHeader {
     static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
 
+    //! \name Offsets of fields in a serialized header
+    //!@{
+    static constexpr size_t SEQNO_OFFSET = 4;
+    static constexpr size_t ACKNO_OFFSET = 8;
+    static constexpr size_t WIN_OFFSET = 14;
+    static constexpr size_t CKSUM_OFFSET = 16;
+    //!@}
+
     //! \struct TCPHeader
     //! ~~~{.txt}
     //!   0                   1                   2                   3
@@ -48,14 +57,34 @@ struct TCPHeader {
     uint16_t win = 0;           //!< window size
     uint16_t cksum = 0;         //!< checksum
     uint16_t uptr = 0;          //!< urgent pointer
+    TCPOptions options{};       //!< options
     //!@}
 
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
+    //! Parse the TCP fields one at a time through the NetParser (the general path behind parse())
+    ParseResult parse_fields(NetParser &p);
+
+    //! Number of bytes in the serialized header: 4 * `doff`, or more if that's too short for the options
+    size_t length() const;
+
     //! Serialize the TCP fields
     std::string serialize() const;
 
+    //! \brief Serialize the TCP fields into `out`, which has room for `size` bytes
+    //! \returns the ones' complement sum of the header's 16-bit words, added up while writing them
+    uint32_t serialize_into(char *out, const size_t size) const;
+
+    //! \name Rewrite a field of a serialized header
+    //! These overwrite one field of a header that serialize() produced, and update the header's
+    //! checksum incrementally ([RFC 1624](\ref rfc::rfc1624)), without reading the payload.
+    //!@{
+    static void rewrite_seqno(std::string &serialized, const WrappingInt32 seqno);
+    static void rewrite_ackno(std::string &serialized, const WrappingInt32 ackno);
+    static void rewrite_win(std::string &serialized, const uint16_t win);
+    //!@}
+
     //! Return a string containing a header in human-readable format
     std::string to_string() const;
 
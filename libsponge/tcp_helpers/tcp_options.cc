@@ -0,0 +1,150 @@
+#include "tcp_options.hh"
+
+#include "parser.hh"
+
+#include <algorithm>
+#include <sstream>
+
+using namespace std;
+
+//! \param[in] data is the header's option bytes, 4 * `doff` - 20 of them
+//! \details Parsing stops at the end-of-options marker, or at an option whose length
+//! runs past the end of `data`; the options before it are kept.
+void TCPOptions::parse(string_view data) {
+    *this = {};
+
+    size_t i = 0;
+    while (i < data.size()) {
+        const uint8_t kind = data[i];
+        if (kind == END) {
+            break;
+        }
+        if (kind == NOP) {
+            ++i;
+            continue;
+        }
+
+        // every other option has a length, which counts its kind and length bytes
+        if (i + 1 >= data.size()) {
+            break;
+        }
+        const size_t len = uint8_t(data[i + 1]);
+        if (len < 2 or i + len > data.size()) {
+            break;
+        }
+
+        const char *const value = data.data() + i + 2;
+        switch (kind) {
+            case MSS:
+                if (len == 4) {
+                    mss = NetParser::load_u16(value);
+                }
+                break;
+            case WINDOW_SCALE:
+                if (len == 3) {
+                    window_scale = uint8_t(value[0]);
+                }
+                break;
+            case SACK_PERMITTED:
+                sack_permitted = sack_permitted or len == 2;
+                break;
+            case SACK:
+                if ((len - 2) % 8 == 0) {
+                    sack_block_count = min((len - 2) / 8, MAX_SACK_BLOCKS);
+                    for (size_t block = 0; block < sack_block_count; ++block) {
+                        sack_blocks[block] = {WrappingInt32{NetParser::load_u32(value + 8 * block)},
+                                              WrappingInt32{NetParser::load_u32(value + 8 * block + 4)}};
+                    }
+                }
+                break;
+            case TIMESTAMPS:
+                if (len == 10) {
+                    timestamps = Timestamps{NetParser::load_u32(value), NetParser::load_u32(value + 4)};
+                }
+                break;
+            default:  // not understood, so skip it
+                break;
+        }
+        i += len;
+    }
+}
+
+//! \details Each option is written with NOPs in front of it, to keep it 4-byte aligned
+//! the way the RFCs suggest.
+size_t TCPOptions::length() const {
+    return (mss ? 4 : 0) + (window_scale ? 4 : 0) + (sack_permitted ? 4 : 0) + (timestamps ? 12 : 0) +
+           (sack_block_count ? 4 + 8 * sack_block_count : 0);
+}
+
+//! \param[out] out is where length() bytes of options are written
+void TCPOptions::serialize_into(char *out) const {
+    // write `nops` NOPs, then an option's kind and length, and return where its value goes
+    const auto start_option = [&](const size_t nops, const uint8_t kind, const size_t len) {
+        out = fill_n(out, nops, char(NOP));
+        *out++ = char(kind);
+        *out++ = char(len);
+        char *const value = out;
+        out += len - 2;
+        return value;
+    };
+
+    if (mss) {
+        NetUnparser::store_u16(start_option(0, MSS, 4), *mss);
+    }
+    if (window_scale) {
+        *start_option(1, WINDOW_SCALE, 3) = char(*window_scale);
+    }
+    if (sack_permitted) {
+        start_option(2, SACK_PERMITTED, 2);
+    }
+    if (timestamps) {
+        char *const value = start_option(2, TIMESTAMPS, 10);
+        NetUnparser::store_u32(value, timestamps->value);
+        NetUnparser::store_u32(value + 4, timestamps->echo_reply);
+    }
+    if (sack_block_count) {
+        char *const value = start_option(2, SACK, 2 + 8 * sack_block_count);
+        for (size_t block = 0; block < sack_block_count; ++block) {
+            NetUnparser::store_u32(value + 8 * block, sack_blocks[block].begin.raw_value());
+            NetUnparser::store_u32(value + 8 * block + 4, sack_blocks[block].end.raw_value());
+        }
+    }
+}
+
+//! \returns A string with the options, one per line
+string TCPOptions::to_string() const {
+    stringstream ss{};
+    if (mss) {
+        ss << "TCP MSS: " << *mss << '\n';
+    }
+    if (window_scale) {
+        ss << "TCP window scale: " << +*window_scale << '\n';
+    }
+    if (sack_permitted) {
+        ss << "TCP SACK permitted\n";
+    }
+    for (size_t block = 0; block < sack_block_count; ++block) {
+        ss << "TCP SACK block: " << sack_blocks[block].begin << '-' << sack_blocks[block].end << '\n';
+    }
+    if (timestamps) {
+        ss << "TCP timestamps: " << timestamps->value << ' ' << timestamps->echo_reply << '\n';
+    }
+    return ss.str();
+}
+
+bool TCPOptions::operator==(const TCPOptions &other) const {
+    const auto same_timestamps = [](const Timestamps &a, const Timestamps &b) {
+        return a.value == b.value and a.echo_reply == b.echo_reply;
+    };
+    if (not(mss == other.mss and window_scale == other.window_scale and sack_permitted == other.sack_permitted and
+            sack_block_count == other.sack_block_count and timestamps.has_value() == other.timestamps.has_value())) {
+        return false;
+    }
+    if (timestamps and not same_timestamps(*timestamps, *other.timestamps)) {
+        return false;
+    }
+    return equal(sack_blocks.begin(),
+                 sack_blocks.begin() + sack_block_count,
+                 other.sack_blocks.begin(),
+                 [](const SACKBlock &a, const SACKBlock &b) { return a.begin == b.begin and a.end == b.end; });
+}
@@ -0,0 +1,70 @@
+#ifndef SPONGE_LIBSPONGE_TCP_OPTIONS_HH
+#define SPONGE_LIBSPONGE_TCP_OPTIONS_HH
+
+#include "wrapping_integers.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+//! \brief The [TCP](\ref rfc::rfc793) options that are understood
+//! \details These are the maximum segment size, window scale and timestamps
+//! ([RFC 7323](\ref rfc::rfc7323)), and SACK-permitted and SACK blocks ([RFC 2018](\ref rfc::rfc2018)).
+//! Parsing fills in this fixed-size struct without allocating; options that aren't
+//! understood, or have the wrong length, are skipped.
+struct TCPOptions {
+    static constexpr size_t MAX_LENGTH = 40;      //!< Most option bytes that a TCP header can hold
+    static constexpr size_t MAX_SACK_BLOCKS = 4;  //!< Most SACK blocks that fit in the options
+
+    //! \name Option kinds
+    //!@{
+    static constexpr uint8_t END = 0;
+    static constexpr uint8_t NOP = 1;
+    static constexpr uint8_t MSS = 2;
+    static constexpr uint8_t WINDOW_SCALE = 3;
+    static constexpr uint8_t SACK_PERMITTED = 4;
+    static constexpr uint8_t SACK = 5;
+    static constexpr uint8_t TIMESTAMPS = 8;
+    //!@}
+
+    //! A block of sequence space, [`begin`, `end`), that was received
+    struct SACKBlock {
+        WrappingInt32 begin{0};
+        WrappingInt32 end{0};
+    };
+
+    //! The sender's clock, and the most recent clock value it received
+    struct Timestamps {
+        uint32_t value = 0;
+        uint32_t echo_reply = 0;
+    };
+
+    //! \name Options
+    //!@{
+    std::optional<uint16_t> mss{};                         //!< maximum segment size
+    std::optional<uint8_t> window_scale{};                 //!< window scale shift count
+    bool sack_permitted = false;                           //!< SACK-permitted
+    std::array<SACKBlock, MAX_SACK_BLOCKS> sack_blocks{};  //!< SACK blocks
+    size_t sack_block_count = 0;                           //!< number of SACK blocks in use
+    std::optional<Timestamps> timestamps{};                //!< timestamps
+    //!@}
+
+    //! Parse the options from the bytes between the fixed-length header and the payload
+    void parse(std::string_view data);
+
+    //! Number of bytes that serialize_into() writes (a multiple of 4)
+    size_t length() const;
+
+    //! Write the options into `out`, which has room for length() bytes
+    void serialize_into(char *out) const;
+
+    //! Return a string containing the options in human-readable format (empty if none are set)
+    std::string to_string() const;
+
+    bool operator==(const TCPOptions &other) const;
+};
+
+#endif  // SPONGE_LIBSPONGE_TCP_OPTIONS_HH
@@ -3,6 +3,8 @@
 #include "parser.hh"
 #include "util.hh"
 
+#include <iterator>
+#include <stdexcept>
 #include <variant>
 
 using namespace std;
@@ -28,18 +30,66 @@ size_t TCPSegment::length_in_sequence_space() const {
 
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
 BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum) const {
+    string header(_header.length(), 0);
+    serialize_into(header.data(), header.size(), datagram_layer_checksum);
+
+    BufferList ret;
+    ret.append(move(header));
+    ret.append(_payload);
+
+    return ret;
+}
+
+//! \param[out] buffer is where the header is written
+//! \param[in] size is the number of bytes available at `buffer` (at least the header length)
+//! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
+//! \returns iovecs for the header and the payload
+array<iovec, 2> TCPSegment::serialize_into(char *buffer,
+                                           const size_t size,
+                                           const uint32_t datagram_layer_checksum) const {
     TCPHeader header_out = _header;
     header_out.cksum = 0;
 
-    // calculate checksum -- taken over entire segment
-    InternetChecksum check(datagram_layer_checksum);
-    check.add(header_out.serialize());
+    // calculate checksum -- taken over entire segment, starting from the header's sum
+    InternetChecksum check(uint64_t(datagram_layer_checksum) + header_out.serialize_into(buffer, size));
     check.add(_payload);
-    header_out.cksum = check.value();
 
-    BufferList ret;
-    ret.append(header_out.serialize());
-    ret.append(_payload);
+    // fill in the checksum field of the serialized header
+    NetUnparser::store_u16(buffer + TCPHeader::CKSUM_OFFSET, check.value());
+
+    return {iovec{buffer, header_out.length()},
+            iovec{const_cast<char *>(_payload.str().data()), _payload.size()}};
+}
+
+//! \param[in] serialized is a segment produced by serialize()
+//! \param[in] seqno is the new sequence number
+//! \param[in] ackno is the new ack number
+//! \param[in] win is the new window size
+//! \returns the rewritten segment, which shares the payload with `serialized`
+BufferList TCPSegment::rewrite(const BufferList &serialized,
+                               const WrappingInt32 seqno,
+                               const WrappingInt32 ackno,
+                               const uint16_t win) {
+    if (serialized.buffers().empty() or serialized.buffers().front().size() < TCPHeader::LENGTH) {
+        throw runtime_error("TCPSegment::rewrite: segment doesn't start with a TCP header");
+    }
 
+    // copy just the header (including any options) out of the first buffer
+    Buffer rest = serialized.buffers().front();
+    const size_t header_length = min(size_t(4 * (rest.at(12) >> 4)), rest.size());
+    string header{rest.str().substr(0, header_length)};
+    rest.remove_prefix(header_length);
+
+    TCPHeader::rewrite_seqno(header, seqno);
+    TCPHeader::rewrite_ackno(header, ackno);
+    TCPHeader::rewrite_win(header, win);
+
+    BufferList ret{move(header)};
+    if (rest.size()) {
+        ret.append(rest);
+    }
+    for (auto buffer = next(serialized.buffers().begin()); buffer != serialized.buffers().end(); ++buffer) {
+        ret.append(*buffer);
+    }
     return ret;
 }
@@ -4,7 +4,9 @@
 #include "buffer.hh"
 #include "tcp_header.hh"
 
+#include <array>
 #include <cstdint>
+#include <sys/uio.h>
 
 //! \brief [TCP](\ref rfc::rfc793) segment
 class TCPSegment {
@@ -19,6 +21,22 @@ class TCPSegment {
     //! \brief Serialize the segment to a string
     BufferList serialize(const uint32_t datagram_layer_checksum = 0) const;
 
+    //! \brief Serialize the segment's header into caller-provided memory (e.g. a pooled packet buffer)
+    //! \details The header is written once, and summed while it is written. Nothing is allocated:
+    //! the returned iovecs point at the header in `buffer` and at the payload, ready for
+    //! [writev(2)](\ref man2::writev), and are valid as long as both of those are.
+    std::array<iovec, 2> serialize_into(char *buffer,
+                                        const size_t size,
+                                        const uint32_t datagram_layer_checksum = 0) const;
+
+    //! \brief Rewrite the seqno, ackno and window of a segment that serialize() produced
+    //! \details Only the header is copied, and its checksum is updated incrementally, so a
+    //! retransmission or a refreshed ACK costs the same whatever the payload length.
+    static BufferList rewrite(const BufferList &serialized,
+                              const WrappingInt32 seqno,
+                              const WrappingInt32 ackno,
+                              const uint16_t win);
+
     //! \name Accessors
     //!@{
     const TCPHeader &header() const { return _header; }
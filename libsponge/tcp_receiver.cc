@@ -1,5 +1,7 @@
 #include "tcp_receiver.hh"
 
+#include <algorithm>
+
 // Dummy implementation of a TCP receiver
 
 // For Lab 2, please replace with a real implementation that passes the
@@ -10,51 +12,102 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
+void TCPReceiver::syn_received(const TCPHeader &header) {
+    // if the segment contains SYN flag, then the SN field is the ISN
+    this->ISN = header.seqno.raw_value();
+    /*
+     * only initialize ASN if it hasn't been initialized, so as to be
+     * idempotent if the SYN segment was received multiple times with
+     * delays in between.
+     */
+    if (this->ASN == 0)
+        this->ASN = 1;
+
+    // window scaling is in effect if the SYN asked for it; a shift count above 14 is treated as 14
+    if (header.options.window_scale)
+        this->_peer_window_scale = std::min(*header.options.window_scale, MAX_WINDOW_SCALE);
+
+    this->_sack_permitted = header.options.sack_permitted;
+}
+
+uint64_t TCPReceiver::stream_index(const TCPHeader &header, const uint64_t checkpoint) const {
+    /*
+     * the stream index does not account for SYN or FIN. If the segment has the
+     * SYN flag, its SN field equals to the ISN, so the SN-derived ASN will be 0;
+     * the correct stream index in this case is also 0. If the segment doesn't
+     * have the SYN flag, the SN-derived ASN has accounted for SYN flag as its
+     * 0th byte, so ASN is one index larger than the stream index; the correct
+     * stream index in this case is ASN - 1.
+     */
+    return header.syn ? 0 : unwrap(header.seqno, WrappingInt32(this->ISN), checkpoint) - 1;
+}
+
+void TCPReceiver::update_asn() {
+    /*
+     * The ASN is one past the last contiguous byte: the SYN, then every byte
+     * written into the stream, then the FIN once the input has ended.
+     */
+    this->ASN = 1 + this->stream_out().bytes_written() + (this->stream_out().input_ended() ? 1 : 0);
+}
+
 /**
  * @brief Process a received TCP segment.
  *
  * @param seg The received TCP segment
  */
 void TCPReceiver::segment_received(const TCPSegment &seg) {
-    // if the segment contains SYN flag, then the SN field is the ISN
-    if (seg.header().syn) {
-        this->ISN = seg.header().seqno.raw_value();
-        /*
-         * only initialize ASN if it hasn't been initialized, so as to be
-         * idempotent if the SYN segment was received multiple times with
-         * delays in between.
-         */
-        if (this->ASN == 0)
-            this->ASN = 1;
-    }
+    if (seg.header().syn)
+        this->syn_received(seg.header());
 
     // only perform the following if a segment with SYN flag was received
-    if (this->ASN != 0) {
-        /*
-         * the stream index does not account for SYN or FIN. If the segment has the
-         * SYN flag, its SN field equals to the ISN, so the SN-derived ASN will be 0;
-         * the correct stream index in this case is also 0. If the segment doesn't
-         * have the SYN flag, the SN-derived ASN has accounted for SYN flag as its
-         * 0th byte, so ASN is one index larger than the stream index; the correct
-         * stream index in this case is ASN - 1.
-         */
-        uint64_t stream_index =
-            seg.header().syn ? 0 : unwrap(seg.header().seqno, WrappingInt32(this->ISN), this->ASN) - 1;
-        string data = seg.payload().copy();
-
-        size_t size_before = this->stream_out().buffer_size();
-        this->_reassembler.push_substring(data, stream_index, seg.header().fin);
-        size_t size_after = this->stream_out().buffer_size();
-
-        // if any bytes were written into the stream, then they were contiguous,
-        // so the AAN should be forwarded accordingly.
-        size_t size_diff = size_after - size_before;
-        this->ASN += size_diff;
-
-        // if the input has ended, increment ASN to account for FIN
-        if (this->stream_out().input_ended())
-            this->ASN++;
+    if (this->ASN == 0)
+        return;
+
+    // hand the payload over by reference, so that in-order data need not be copied at all
+    this->_reassembler.push_substring(seg.payload(), this->stream_index(seg.header(), this->ASN), seg.header().fin);
+    this->update_asn();
+}
+
+/**
+ * @brief Process a burst of received TCP segments in stream order; see the
+ * header for how that can differ from passing each one to segment_received().
+ *
+ * @param segments The received TCP segments, in the order they arrived
+ */
+void TCPReceiver::segments_received(const std::vector<TCPSegment> &segments) {
+    /*
+     * Find each segment's stream index, against the ASN before the burst. As
+     * one at a time, segments that arrive before any SYN are dropped.
+     */
+    this->_burst.clear();
+    for (const TCPSegment &seg : segments) {
+        if (seg.header().syn)
+            this->syn_received(seg.header());
+        if (this->ASN != 0)
+            this->_burst.emplace_back(this->stream_index(seg.header(), this->ASN), &seg);
+    }
+
+    /*
+     * Sort the segments by stream index, so that each one continues the bytes
+     * before it and goes straight into the output stream rather than through
+     * the window. A burst arrives nearly in order, so an insertion sort takes
+     * about linear time; it is also stable, so that of two segments at the same
+     * index, the one that arrived first still wins.
+     */
+    for (size_t i = 1; i < this->_burst.size(); i++) {
+        const auto segment = this->_burst[i];
+        size_t j = i;
+        for (; j > 0 && this->_burst[j - 1].first > segment.first; j--)
+            this->_burst[j] = this->_burst[j - 1];
+        this->_burst[j] = segment;
     }
+
+    for (const auto &[index, seg] : this->_burst)
+        this->_reassembler.push_substring(seg->payload(), index, seg->header().fin);
+
+    // the ASN only needs to be worked out once for the whole burst
+    if (!this->_burst.empty())
+        this->update_asn();
 }
 
 /**
@@ -81,3 +134,53 @@ optional<WrappingInt32> TCPReceiver::ackno() const {
  * @return size_t
  */
 size_t TCPReceiver::window_size() const { return this->_capacity - this->stream_out().buffer_size(); }
+
+/**
+ * @brief Returns the value for the 16-bit window field of a segment (other
+ * than a SYN) sent to the remote TCPSender.
+ *
+ * @return uint16_t
+ */
+uint16_t TCPReceiver::advertised_window() const {
+    // shifting rounds down, so the remote TCPSender never sees more room than there is
+    size_t window = this->window_size();
+    if (this->window_scaling())
+        window >>= this->_window_scale;
+    return uint16_t(std::min(window, size_t(UINT16_MAX)));
+}
+
+/**
+ * @brief Fills in the SACK blocks of the options for a segment sent to the
+ * remote TCPSender, one for each range of bytes received beyond the ackno.
+ *
+ * @param options The options whose sack_blocks and sack_block_count are set.
+ * @param max_blocks The most blocks to fill in; fewer are if no more fit beside
+ * the other options already set.
+ */
+void TCPReceiver::sack_blocks(TCPOptions &options, const size_t max_blocks) const {
+    options.sack_block_count = 0;
+    if (!this->_sack_permitted || this->ASN == 0)
+        return;
+
+    // the SACK option takes 2 bytes (plus 2 of padding) and 8 per block, beside the options already set
+    const size_t other_length = options.length();
+    const size_t fit = other_length + 4 < TCPOptions::MAX_LENGTH ? (TCPOptions::MAX_LENGTH - other_length - 4) / 8 : 0;
+
+    std::array<StreamReassembler::Range, StreamReassembler::MAX_RECENT_RANGES> ranges{};
+    const size_t count = this->_reassembler.recent_ranges(
+        ranges, std::min({max_blocks, fit, TCPOptions::MAX_SACK_BLOCKS}));
+
+    // the SYN is the 0th sequence number, so a stream index is one less than its absolute sequence number
+    for (size_t i = 0; i < count; i++) {
+        options.sack_blocks[i].begin = wrap(ranges[i].first + 1, WrappingInt32(this->ISN));
+        options.sack_blocks[i].end = wrap(ranges[i].second + 1, WrappingInt32(this->ISN));
+    }
+    options.sack_block_count = count;
+}
+
+uint8_t TCPReceiver::window_scale_for(const size_t capacity) {
+    uint8_t shift = 0;
+    while (shift < MAX_WINDOW_SCALE && (capacity >> shift) > UINT16_MAX)
+        shift++;
+    return shift;
+}
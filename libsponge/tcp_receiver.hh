@@ -3,10 +3,13 @@
 
 #include "byte_stream.hh"
 #include "stream_reassembler.hh"
+#include "tcp_options.hh"
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 
 #include <optional>
+#include <utility>
+#include <vector>
 
 //! \brief The "receiver" part of a TCP implementation.
 
@@ -21,14 +24,53 @@ class TCPReceiver {
     uint32_t ISN{0};   //! The initial sequence number.
     uint64_t ASN{0};   //! The absolute sequence number, also the absolute acknowledgement number.
 
+    uint8_t _window_scale;                        //! The shift count for the windows we advertise.
+    std::optional<uint8_t> _peer_window_scale{};  //! The shift count from the SYN's window scale option.
+    bool _sack_permitted{false};                  //! Whether the SYN carried the SACK-permitted option.
+
+    //! The stream index and segment of each segment in the burst being processed, kept to reuse its storage.
+    std::vector<std::pair<uint64_t, const TCPSegment *>> _burst{};
+
+    /**
+     * @brief Take the ISN and the negotiated options from a SYN.
+     *
+     * @param header The header of a segment with the SYN flag
+     */
+    void syn_received(const TCPHeader &header);
+
+    /**
+     * @brief Returns the stream index of a segment's first payload byte.
+     *
+     * @param header The header of the segment
+     * @param checkpoint The ASN to unwrap its seqno against
+     * @return uint64_t
+     */
+    uint64_t stream_index(const TCPHeader &header, const uint64_t checkpoint) const;
+
+    //! Set the ASN from the bytes assembled so far, and the FIN if the input has ended.
+    void update_asn();
+
+    /**
+     * @brief Returns the smallest shift count that lets the whole capacity be
+     * advertised in 16 bits, up to MAX_WINDOW_SCALE.
+     *
+     * @param capacity The maximum number of bytes that the receiver will store
+     * @return uint8_t
+     */
+    static uint8_t window_scale_for(const size_t capacity);
+
   public:
+    //! The largest window scale shift count allowed by RFC 7323.
+    static constexpr uint8_t MAX_WINDOW_SCALE = 14;
+
     /**
      * @brief Construct a new TCPReceiver object.
      *
      * @param capacity The maximum number of bytes that the receiver will store
      * in its StreamReassembler buffer.
      */
-    TCPReceiver(const size_t capacity) : _reassembler(capacity), _capacity(capacity) {}
+    TCPReceiver(const size_t capacity)
+        : _reassembler(capacity), _capacity(capacity), _window_scale(window_scale_for(capacity)) {}
 
     //! \brief number of bytes stored but not yet reassembled
     size_t unassembled_bytes() const { return _reassembler.unassembled_bytes(); }
@@ -46,6 +88,22 @@ class TCPReceiver {
      */
     void segment_received(const TCPSegment &seg);
 
+    /**
+     * @brief Process a burst of received TCP segments (e.g. from one
+     * [recvmmsg(2)](\ref man2::recvmmsg) call). The segments are not handled
+     * in arrival order, but the output stream ends up with the same contents,
+     * and the ackno with the same value, as after passing each one to
+     * segment_received() in turn (save for the one case below).
+     * @note The segments are put in stream order first, so that out-of-order
+     * segments within the burst still go straight into the output stream, and
+     * the ackno is worked out once for the whole burst. So a segment that would
+     * have been beyond the window on its own can be taken, if the segments before
+     * it in the stream arrived later in the same burst.
+     *
+     * @param segments The received TCP segments, in the order they arrived
+     */
+    void segments_received(const std::vector<TCPSegment> &segments);
+
     //! \name Accessors to provide feedback to the remote TCPSender
     //!@{
 
@@ -64,6 +122,68 @@ class TCPReceiver {
      * @return size_t
      */
     size_t window_size() const;
+
+    /**
+     * @brief Returns the value for the 16-bit window field of a segment
+     * (other than a SYN) sent to the remote TCPSender.
+     *
+     * @note If the SYN carried a window scale option, window scaling is in
+     * effect ([RFC 7323](\ref rfc::rfc7323)), and the window is shifted right by
+     * window_scale(), rounding down. Either way, a window that doesn't fit is
+     * clamped to 65535 rather than truncated.
+     *
+     * @return uint16_t
+     */
+    uint16_t advertised_window() const;
+
+    /**
+     * @brief Returns the shift count to send in our own window scale option,
+     * chosen so that the whole capacity can be advertised.
+     *
+     * @return uint8_t
+     */
+    uint8_t window_scale() const { return _window_scale; }
+
+    /**
+     * @brief Returns whether the SYN negotiated window scaling, i.e. whether
+     * advertised_window() is scaled.
+     *
+     * @return bool
+     */
+    bool window_scaling() const { return _peer_window_scale.has_value(); }
+
+    /**
+     * @brief Returns the remote TCPSender's shift count from its window scale
+     * option (at most MAX_WINDOW_SCALE), or an empty std::optional object if the
+     * SYN carried none.
+     *
+     * @return std::optional<uint8_t>
+     */
+    std::optional<uint8_t> peer_window_scale() const { return _peer_window_scale; }
+
+    /**
+     * @brief Returns whether the SYN carried the SACK-permitted option, i.e.
+     * whether sack_blocks() reports anything.
+     *
+     * @return bool
+     */
+    bool sack_permitted() const { return _sack_permitted; }
+
+    /**
+     * @brief Fills in the SACK blocks ([RFC 2018](\ref rfc::rfc2018)) of the
+     * options for a segment sent to the remote TCPSender, one for each range of
+     * bytes received beyond the ackno.
+     *
+     * @note The block holding the most recently received segment comes first, as
+     * RFC 2018 requires, followed by the blocks of the segments before it. No
+     * blocks are filled in unless the SYN permitted SACK, and never more than
+     * fit in the option space left by the other options already set (3 beside
+     * timestamps), so set those first.
+     *
+     * @param options The options whose sack_blocks and sack_block_count are set.
+     * @param max_blocks The most blocks to fill in.
+     */
+    void sack_blocks(TCPOptions &options, const size_t max_blocks = TCPOptions::MAX_SACK_BLOCKS) const;
     //!@}
 };
 
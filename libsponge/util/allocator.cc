@@ -0,0 +1,6 @@
+#include "allocator.hh"
+
+HeapAllocator &HeapAllocator::instance() {
+    static HeapAllocator allocator;
+    return allocator;
+}
@@ -0,0 +1,41 @@
+#ifndef SPONGE_LIBSPONGE_ALLOCATOR_HH
+#define SPONGE_LIBSPONGE_ALLOCATOR_HH
+
+#include <cstddef>
+
+//! \brief Where ByteStream and StreamReassembler get their storage from
+//! \details Blocks are plain bytes, aligned for any fundamental type, and are
+//! handed back with the same size they were allocated with. The default is
+//! HeapAllocator, which goes straight to the heap and may be used from any
+//! thread; a thread's PagePool is faster under connection churn, for callers
+//! that keep each stream on one thread.
+class Allocator {
+  public:
+    static constexpr size_t PAGE_SIZE = 4096;  //!< Bytes in a page, the unit of paged storage
+
+    virtual ~Allocator() = default;
+
+    //! \brief Allocate an uninitialized block of `size` bytes
+    virtual char *allocate(const size_t size) = 0;
+
+    //! \brief Give back a block of `size` bytes that came from allocate(`size`)
+    virtual void deallocate(char *block, const size_t size) = 0;
+
+    //! \brief Allocate an uninitialized page of PAGE_SIZE bytes
+    char *allocate_page() { return allocate(PAGE_SIZE); }
+
+    //! \brief Give back a page that came from allocate_page()
+    void deallocate_page(char *page) { deallocate(page, PAGE_SIZE); }
+};
+
+//! \brief An Allocator that uses new[] and delete[] for every block
+class HeapAllocator : public Allocator {
+  public:
+    char *allocate(const size_t size) override { return new char[size]; }
+    void deallocate(char *block, const size_t /* size */) override { delete[] block; }
+
+    //! \brief The one HeapAllocator, which any thread may use
+    static HeapAllocator &instance();
+};
+
+#endif  // SPONGE_LIBSPONGE_ALLOCATOR_HH
@@ -0,0 +1,144 @@
+#include "bitmap_set.hh"
+
+#include "util.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+//! \param[in] capacity is the largest distance between the lowest and highest possible member, plus one
+//! \param[in] allocator is where pages of words are taken from
+BitmapSet::BitmapSet(const size_t capacity, Allocator &allocator)
+    : _allocator(&allocator)
+    , _pages()
+    , _bit_mask(round_up_to_power_of_two(max(capacity, size_t(WORD_BITS))) - 1) {
+    // a ring smaller than a page still takes a whole one
+    _pages.resize((_bit_mask / WORD_BITS) / WORDS_PER_PAGE + 1, nullptr);
+}
+
+BitmapSet::BitmapSet(BitmapSet &&other) noexcept
+    : _allocator(other._allocator)
+    , _pages(move(other._pages))
+    , _held(move(other._held))
+    , _bit_mask(other._bit_mask)
+    , _base(other._base)
+    , _size(exchange(other._size, 0)) {
+    other._pages.assign(_pages.size(), nullptr);
+    other._held.clear();
+}
+
+BitmapSet &BitmapSet::operator=(BitmapSet &&other) noexcept {
+    if (this != &other) {
+        _release_pages();
+        _allocator = other._allocator;
+        _pages = move(other._pages);
+        _held = move(other._held);
+        _bit_mask = other._bit_mask;
+        _base = other._base;
+        _size = exchange(other._size, 0);
+        other._pages.assign(_pages.size(), nullptr);
+        other._held.clear();
+    }
+    return *this;
+}
+
+uint64_t &BitmapSet::_word_to_set(const uint64_t bit) {
+    const size_t position = bit / WORD_BITS / WORDS_PER_PAGE;
+    uint64_t *&page = _pages[position];
+    if (not page) {
+        // an Allocator's blocks are suitably aligned for any fundamental type
+        page = reinterpret_cast<uint64_t *>(_allocator->allocate_page());
+        fill(page, page + WORDS_PER_PAGE, 0);
+        _held.push_back(position);
+    }
+    return page[bit / WORD_BITS % WORDS_PER_PAGE];
+}
+
+void BitmapSet::_release_pages() {
+    for (const size_t position : _held) {
+        _allocator->deallocate_page(reinterpret_cast<char *>(_pages[position]));
+        _pages[position] = nullptr;
+    }
+    _held.clear();
+}
+
+void BitmapSet::_assign(uint64_t begin, const uint64_t end, const bool value) {
+    while (begin < end) {
+        const uint64_t bit = begin & _bit_mask;
+        const uint64_t offset = bit % WORD_BITS;
+        const uint64_t count = min(WORD_BITS - offset, end - begin);
+        const uint64_t mask = (count == WORD_BITS ? ~uint64_t(0) : (uint64_t(1) << count) - 1) << offset;
+
+        if (value) {
+            uint64_t &word = _word_to_set(bit);
+            _size += __builtin_popcountll(mask & ~word);
+            word |= mask;
+        } else if (_word(bit) & mask) {
+            uint64_t &word = _word_to_set(bit);
+            _size -= __builtin_popcountll(mask & word);
+            word &= ~mask;
+        }
+        begin += count;
+    }
+}
+
+//! \param[in] index is the smallest index that stays in the set
+void BitmapSet::erase_below(const uint64_t index) {
+    if (index <= _base) {
+        return;
+    }
+
+    // an empty set has no bits to clear, however far the base moves
+    if (_size) {
+        _assign(_base, min(index, _base + _bit_mask + 1), false);
+    }
+    _base = index;
+
+    // and once the last member is gone, it needs no pages either
+    if (not _size) {
+        _release_pages();
+    }
+}
+
+//! \param[in] index is where the run of members starts
+uint64_t BitmapSet::contiguous_end(const uint64_t index) const {
+    uint64_t end = index;
+    while (end - index <= _bit_mask) {
+        const uint64_t bit = end & _bit_mask;
+        const uint64_t offset = bit % WORD_BITS;
+
+        // the lowest clear bit at or above `offset` ends the run; the shift fills the top with zeros,
+        // so a non-zero result always comes from a clear bit inside this word
+        const uint64_t clear_bits = ~_word(bit) >> offset;
+        if (clear_bits) {
+            return end + __builtin_ctzll(clear_bits);
+        }
+        end += WORD_BITS - offset;
+    }
+    return index + _bit_mask + 1;
+}
+
+//! \param[in] index is the member whose interval is wanted
+pair<uint64_t, uint64_t> BitmapSet::interval_containing(const uint64_t index) const {
+    const uint64_t end = index - _base <= _bit_mask ? contiguous_end(index) : index;
+    if (end == index) {
+        return {index, index};
+    }
+
+    // scan down from `index` for the highest clear bit below it, but not past `_base`
+    uint64_t begin = index;
+    while (begin > _base) {
+        const uint64_t bit = (begin - 1) & _bit_mask;
+        const uint64_t offset = bit % WORD_BITS;
+
+        // move the bit for `begin - 1` to the top; the shift fills the bottom with zeros,
+        // so a non-zero result always comes from a clear bit inside this word
+        const uint64_t clear_bits = ~_word(bit) << (WORD_BITS - 1 - offset);
+        if (clear_bits) {
+            begin -= __builtin_clzll(clear_bits);
+            break;
+        }
+        begin -= min(offset + 1, begin - _base);
+    }
+    return {max(begin, _base), end};
+}
@@ -0,0 +1,91 @@
+#ifndef SPONGE_LIBSPONGE_BITMAP_SET_HH
+#define SPONGE_LIBSPONGE_BITMAP_SET_HH
+
+#include "page_pool.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+//! \brief A set of 64-bit indices that all lie within a sliding range of `capacity` indices
+//! \details Members are stored as bits in a ring of 64-bit words. Updates and
+//! scans work a word at a time (using popcount and count-trailing-zeros), and
+//! the number of members is maintained on every update, so size() is O(1).
+//!
+//! The words are kept in pages from an Allocator, and a page is only taken when
+//! a member is first inserted into it; a missing page reads as all clear. Once
+//! the set is empty again its pages are given back, so a set that seldom
+//! has members costs next to nothing whatever its capacity.
+//!
+//! The members must always lie in [`base`, `base` + `capacity`), where `base`
+//! starts at zero and is only moved forward by erase_below().
+class BitmapSet {
+  private:
+    static constexpr size_t WORDS_PER_PAGE = PagePool::PAGE_SIZE / sizeof(uint64_t);
+
+    Allocator *_allocator;           //!< Where pages of words come from and go back to
+    std::vector<uint64_t *> _pages;  //!< The ring of words, a page at a time, or nullptr for a page of zeros
+    std::vector<size_t> _held{};     //!< The positions in `_pages` of the pages held
+    uint64_t _bit_mask;              //!< Number of bits in the ring minus one
+    uint64_t _base{0};               //!< No member is below this index
+    size_t _size{0};                 //!< Number of set bits
+
+    //! The word that holds bit `bit` of the ring
+    uint64_t _word(const uint64_t bit) const {
+        const uint64_t *page = _pages[bit / WORD_BITS / WORDS_PER_PAGE];
+        return page ? page[bit / WORD_BITS % WORDS_PER_PAGE] : 0;
+    }
+
+    //! The word that holds bit `bit` of the ring, taking a page for it if needed
+    uint64_t &_word_to_set(const uint64_t bit);
+
+    //! Give back every page held
+    void _release_pages();
+
+    //! Set (or clear) the bits for the indices in [`begin`, `end`), and update the member count
+    void _assign(uint64_t begin, const uint64_t end, const bool value);
+
+  public:
+    static constexpr uint64_t WORD_BITS = 64;  //!< Bits in a word
+
+    //! \brief Construct an empty set whose members span at most `capacity` consecutive indices
+    BitmapSet(const size_t capacity, Allocator &allocator = HeapAllocator::instance());
+
+    //! \brief Give back every page held
+    ~BitmapSet() { _release_pages(); }
+
+    BitmapSet(const BitmapSet &) = delete;
+    BitmapSet &operator=(const BitmapSet &) = delete;
+
+    //! \brief Take over the members of `other`, which is left empty
+    BitmapSet(BitmapSet &&other) noexcept;
+
+    //! \brief Give back every page held, and take over the members of `other`, which is left empty
+    BitmapSet &operator=(BitmapSet &&other) noexcept;
+
+    //! \brief Add the indices in [`begin`, `end`) to the set
+    void insert(const uint64_t begin, const uint64_t end) { _assign(begin, end, true); }
+
+    //! \brief Remove every index below `index` from the set
+    void erase_below(const uint64_t index);
+
+    //! \returns one past the last index of the run of members that starts at `index`,
+    //! or `index` itself if it is not a member
+    uint64_t contiguous_end(const uint64_t index) const;
+
+    //! \returns the interval [`begin`, `end`) that holds `index`,
+    //! or an empty interval at `index` if it is not a member
+    std::pair<uint64_t, uint64_t> interval_containing(const uint64_t index) const;
+
+    //! \brief Number of indices in the set
+    size_t size() const { return _size; }
+
+    //! \brief Whether the set has no members
+    bool empty() const { return _size == 0; }
+
+    //! \brief Number of pages of words held
+    size_t pages() const { return _held.size(); }
+};
+
+#endif  // SPONGE_LIBSPONGE_BITMAP_SET_HH
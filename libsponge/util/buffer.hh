@@ -15,6 +15,7 @@ class Buffer {
   private:
     std::shared_ptr<std::string> _storage{};
     size_t _starting_offset{};
+    size_t _ending_offset{};  //!< Number of bytes discarded from the back of the string
 
   public:
     Buffer() = default;
@@ -28,7 +29,7 @@ class Buffer {
         if (not _storage) {
             return {};
         }
-        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset};
+        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset - _ending_offset};
     }
 
     operator std::string_view() const { return str(); }
@@ -46,6 +47,10 @@ class Buffer {
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
     void remove_prefix(const size_t n);
+
+    //! \brief Discard the last `n` bytes of the string (does not require a copy or move)
+    //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
+    void remove_suffix(const size_t n);
 };
 
 //! \brief A reference-counted discontiguous string that can discard bytes from the front
@@ -101,6 +106,8 @@ class BufferViewList {
     //! \name Constructors
     //!@{
 
+    BufferViewList() = default;
+
     //! \brief Construct from a std::string
     BufferViewList(const std::string &str) : BufferViewList(std::string_view(str)) {}
 
@@ -114,6 +121,12 @@ class BufferViewList {
     BufferViewList(std::string_view str) { _views.push_back({const_cast<char *>(str.data()), str.size()}); }
     //!@}
 
+    //! \brief Access the underlying queue of views
+    const std::deque<std::string_view> &views() const { return _views; }
+
+    //! \brief Append a std::string_view (empty views are skipped)
+    void append(std::string_view str);
+
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     void remove_prefix(size_t n);
 
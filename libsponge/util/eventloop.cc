@@ -2,14 +2,56 @@
 
 #include "util.hh"
 
+#ifdef SPONGE_IO_URING
+#include "io_uring.hh"
+#else
+class IoUring {};  // never constructed; lets std::unique_ptr<IoUring> be destroyed
+#endif
+
+#include <algorithm>
 #include <cerrno>
+#include <climits>
+#include <mutex>
 #include <stdexcept>
+#include <sys/stat.h>
 #include <system_error>
 #include <utility>
 #include <vector>
 
 using namespace std;
 
+static_assert(uint32_t(Direction::In) == EPOLLIN and uint32_t(Direction::Out) == EPOLLOUT,
+              "EventLoop::Direction doubles as an epoll event mask");
+
+#ifdef SPONGE_IO_URING
+static constexpr unsigned URING_ENTRIES = 256;    //!< Submissions queued before the queue is flushed early
+static constexpr uint16_t RECEIVE_BUFFERS = 64;  //!< Buffers in the ring shared by receive rules
+#endif
+
+//! \param[in] backend is the kernel interface to wait with
+EventLoop::EventLoop(const Backend backend) : _backend(backend), _timers(timestamp_ms()) {
+    if (_backend == Backend::IoUring) {
+#ifdef SPONGE_IO_URING
+        try {
+            _uring = make_unique<IoUring>(URING_ENTRIES, RECEIVE_BUFFERS, RECEIVE_SIZE);
+        } catch (const exception &) {
+            _backend = Backend::Epoll;  // the kernel lacks io_uring, or a feature of it that we need
+        }
+#else
+        _backend = Backend::Epoll;
+#endif
+    }
+
+    if (_backend == Backend::Epoll) {
+        _epoll.emplace(SystemCall("epoll_create1", ::epoll_create1(EPOLL_CLOEXEC)));
+        _events.resize(64);
+    }
+}
+
+EventLoop::~EventLoop() = default;
+EventLoop::EventLoop(EventLoop &&other) = default;
+EventLoop &EventLoop::operator=(EventLoop &&other) = default;
+
 unsigned int EventLoop::Rule::service_count() const {
     return direction == Direction::In ? fd.read_count() : fd.write_count();
 }
@@ -20,12 +62,300 @@ unsigned int EventLoop::Rule::service_count() const {
 //! \param[in] interest is called by EventLoop::wait_next_event. If it returns `true`, `fd` will
 //!                     be polled, otherwise `fd` will be ignored only for this execution of `wait_next_event.
 //! \param[in] cancel is called when the rule is cancelled (e.g. on hangup, EOF, or closure).
-void EventLoop::add_rule(const FileDescriptor &fd,
-                         const Direction direction,
-                         const CallbackT &callback,
-                         const InterestT &interest,
-                         const CallbackT &cancel) {
+shared_ptr<const EventLoop::RuleCounters> EventLoop::add_rule(const FileDescriptor &fd,
+                                                              const Direction direction,
+                                                              const CallbackT &callback,
+                                                              const InterestT &interest,
+                                                              const CallbackT &cancel) {
     _rules.push_back({fd.duplicate(), direction, callback, interest, cancel});
+    if (_backend != Backend::Poll) {
+        // the kernel hears about the rule at the next wait, once any stale use of its fd number is gone
+        const RuleIterator rule = prev(_rules.end());
+        _parked.push_back(rule);
+        rule->id = _next_id++;
+        _rule_ids.emplace(rule->id, rule);
+
+        // the next wait cancels the rule if fd is closed or at EOF, whether already or by then
+        rule->fd.watch(_fd_changes, rule->id);
+        if (rule->fd.eof()) {
+            const lock_guard<mutex> lock(_fd_changes->mutex);
+            _fd_changes->changed.push_back(rule->id);
+        }
+    }
+    return _rules.back().counters;
+}
+
+//! \param[in] fd is the FileDescriptor to be read
+//! \param[in] callback is given the bytes read each time `fd` is read; it may be called several times per wait.
+//! \param[in] cancel is called when the rule is cancelled (e.g. on hangup, EOF, or closure).
+//! \param[in] budget limits what the rule reads in one wait (except with Backend::IoUring); neither limit may be 0.
+shared_ptr<const EventLoop::RuleCounters> EventLoop::add_receive_rule(const FileDescriptor &fd,
+                                                                      const ReceiveCallbackT &callback,
+                                                                      const CallbackT &cancel,
+                                                                      const Budget &budget) {
+    if (budget.reads == 0 or budget.bytes == 0) {
+        throw invalid_argument("EventLoop: a receive rule's budget must allow at least one read of one byte");
+    }
+    add_rule(fd, Direction::In, {}, [] { return true; }, cancel);
+    Rule &rule = _rules.back();
+    rule.receive = callback;
+    rule.budget = budget;
+
+    // without io_uring, the rule reads `fd` itself; the Rule stays put in the list, so it can be captured.
+    // The first read cannot block, as fd was reported readable. Before each further read, a poll that does
+    // not wait checks that fd still has something (or EOF) to read, so the rule never blocks, and fd's
+    // flags, which it shares with the app, are left alone.
+    rule.callback = [&rule, buffer = string()]() mutable {
+        size_t bytes = 0;
+        for (unsigned reads = 0; reads < rule.budget.reads and bytes < rule.budget.bytes; ++reads) {
+            if (reads > 0) {
+                pollfd readable{rule.fd.fd_num(), POLLIN, 0};
+                if (SystemCall("poll", ::poll(&readable, 1, 0)) == 0) {
+                    return;
+                }
+            }
+            rule.fd.read(buffer, RECEIVE_SIZE);
+            if (buffer.empty()) {
+                return;
+            }
+            bytes += buffer.size();
+            ++rule.counters->callbacks;
+            rule.counters->bytes += buffer.size();
+            rule.receive(buffer);
+            if (rule.fd.closed()) {
+                return;
+            }
+        }
+        ++rule.counters->budget_spent;
+    };
+
+    if (_backend == Backend::IoUring) {
+        struct stat status {};
+        SystemCall("fstat", ::fstat(rule.fd.fd_num(), &status));
+        rule.socket = S_ISSOCK(status.st_mode);
+    }
+    return rule.counters;
+}
+
+//! \param[in] delay_ms is how long from now the timer expires
+//! \param[in] callback is called when the timer expires; it may add and cancel rules and timers.
+TimerWheel::Handle EventLoop::add_timer(const uint64_t delay_ms, const CallbackT &callback) {
+    return _timers.add(timestamp_ms() + delay_ms, callback);
+}
+
+void EventLoop::_cancel_rule(const RuleIterator rule) {
+    if (_backend != Backend::Poll) {
+        if (rule->armed) {
+            _remove_armed(rule);
+        } else {
+            _parked.erase(find(_parked.begin(), _parked.end(), rule));
+        }
+
+        if (rule->registered) {
+            const auto it = _registrations.find(rule->fd.fd_num());
+            Registration &registration = it->second;
+            registration.rules.erase(find(registration.rules.begin(), registration.rules.end(), rule));
+
+            // a closed fd has already left the epoll instance, and its other rules are canceled in turn
+            if (registration.rules.empty()) {
+                if (registration.added and not rule->fd.closed()) {
+                    SystemCall("epoll_ctl", ::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_DEL, it->first, nullptr));
+                }
+                _registrations.erase(it);
+            } else if (not rule->fd.closed()) {
+                _update_registration(it->first, registration);
+            }
+        }
+
+#ifdef SPONGE_IO_URING
+        if (_backend == Backend::IoUring) {
+            // an in-flight operation holds the file open, so it must be canceled even if fd is closed;
+            // its last completion then finds no rule and is dropped
+            if (rule->armed) {
+                _uring->prepare(IORING_OP_ASYNC_CANCEL, -1, 0).addr = rule->id;
+            }
+        }
+#endif
+        rule->fd.unwatch(*_fd_changes, rule->id);
+        _rule_ids.erase(rule->id);
+        rule->armed = false;
+    }
+
+    rule->cancel();
+    _rules.erase(rule);
+}
+
+void EventLoop::_update_registration(const int fd, Registration &registration) {
+    uint32_t events = 0;
+    for (const RuleIterator rule : registration.rules) {
+        if (rule->armed) {
+            events |= uint32_t(rule->direction);
+        }
+    }
+    if (registration.added and events == registration.events) {
+        return;
+    }
+
+    // an fd with no armed rules stays in the instance, like poll's placeholder, so errors are still seen
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+    SystemCall("epoll_ctl",
+               ::epoll_ctl(_epoll->fd_num(), registration.added ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &event));
+    registration.added = true;
+    registration.events = events;
+}
+
+//! \param[in] rule is the rule to arm or park
+//! \param[in] armed is `true` to have the kernel watch the rule's fd for it
+void EventLoop::_set_armed(const RuleIterator rule, const bool armed) {
+    if (rule->armed == armed) {
+        return;
+    }
+    rule->armed = armed;
+    if (armed) {
+        rule->armed_index = _armed.size();
+        _armed.push_back(rule);
+    } else {
+        _remove_armed(rule);
+        _parked.push_back(rule);
+    }
+
+    if (rule->registered) {
+        const auto it = _registrations.find(rule->fd.fd_num());
+        _update_registration(it->first, it->second);
+    }
+    if (armed and _backend == Backend::IoUring) {
+        _submit(rule);
+    }
+}
+
+//! \param[in] rule is an armed rule
+void EventLoop::_remove_armed(const RuleIterator rule) {
+    // the last armed rule takes its place
+    const RuleIterator last = _armed.back();
+    _armed[rule->armed_index] = last;
+    last->armed_index = rule->armed_index;
+    _armed.pop_back();
+}
+
+//! \param[in] rule is the armed rule to submit an operation for
+void EventLoop::_submit([[maybe_unused]] const RuleIterator rule) {
+#ifdef SPONGE_IO_URING
+    if (not rule->receive) {
+        _uring->prepare(IORING_OP_POLL_ADD, rule->fd.fd_num(), rule->id).poll32_events = uint32_t(rule->direction);
+        return;
+    }
+
+    // a multishot receive goes on producing completions until it fails or runs out of buffers
+    io_uring_sqe &sqe = _uring->prepare(rule->socket ? IORING_OP_RECV : IORING_OP_READ, rule->fd.fd_num(), rule->id);
+    sqe.flags = IOSQE_BUFFER_SELECT;
+    sqe.buf_group = IoUring::BUFFER_GROUP;
+    if (rule->socket) {
+        sqe.ioprio = IORING_RECV_MULTISHOT;
+    } else {
+        sqe.len = RECEIVE_SIZE;
+        sqe.off = uint64_t(-1);  // the file's own position
+    }
+#else
+    throw runtime_error("EventLoop: built without io_uring");
+#endif
+}
+
+void EventLoop::_prepare_wait() {
+    // a closed fd, or one at EOF, cancels its rules; only the rules on fds that have changed state are checked
+    {
+        const lock_guard<mutex> lock(_fd_changes->mutex);
+        _changed.swap(_fd_changes->changed);
+    }
+    for (const uint64_t id : _changed) {
+        const auto it = _rule_ids.find(id);
+        if (it == _rule_ids.end()) {
+            continue;  // canceled since
+        }
+        const RuleIterator rule = it->second;
+        if ((rule->direction == Direction::In and rule->fd.eof()) or rule->fd.closed()) {
+            _cancel_rule(rule);
+        }
+    }
+    _changed.clear();
+
+    // register new rules, and arm whichever parked rules have become interested
+    vector<RuleIterator> parked{};
+    parked.swap(_parked);
+    for (const RuleIterator rule : parked) {
+        if (_backend == Backend::Epoll and not rule->registered) {
+            const int fd = rule->fd.fd_num();
+            Registration &registration = _registrations[fd];
+            registration.rules.push_back(rule);
+            rule->registered = true;
+            _update_registration(fd, registration);
+        }
+        if (rule->interest()) {
+            _set_armed(rule, true);
+        } else {
+            _parked.push_back(rule);
+        }
+    }
+}
+
+bool EventLoop::_something_to_wait_for() {
+    if (not _timers.empty()) {
+        return true;
+    }
+    // a rule stays armed until it is next run, so it may have lost interest since; like poll, which asks
+    // every rule each wait, look for an armed rule that is still interested. One found is moved to the
+    // front, so that while it stays interested the next wait asks only it.
+    for (size_t i = 0; i < _armed.size(); ++i) {
+        if (_armed[i]->interest()) {
+            swap(_armed[i], _armed[0]);
+            _armed[i]->armed_index = i;
+            _armed[0]->armed_index = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+//! \param[in] rule is an armed rule
+//! \param[in] events is what the kernel reported for the rule's fd
+bool EventLoop::_run_rule(const RuleIterator rule, const uint32_t events) {
+    const bool ready = events & uint32_t(rule->direction);
+    if (events & POLLHUP and not ready) {
+        // see _wait_poll: the only condition was a hangup, so this fd is defunct
+        if (rule->receive) {
+            rule->fd.set_eof();
+        }
+        _cancel_rule(rule);
+        return false;
+    }
+    if (not ready) {
+        return true;
+    }
+
+    // the rule may have lost interest since it was armed
+    if (not rule->interest()) {
+        _set_armed(rule, false);
+        return false;
+    }
+
+    const auto count_before = rule->service_count();
+    rule->counters->callbacks += not rule->receive;
+    rule->callback();
+
+    if ((rule->direction == Direction::In and rule->fd.eof()) or rule->fd.closed()) {
+        _cancel_rule(rule);
+        return false;
+    }
+
+    const bool interested = rule->interest();
+    if (count_before == rule->service_count() and interested) {
+        throw runtime_error("EventLoop: busy wait detected: callback did not read/write fd and is still interested");
+    }
+    if (not interested) {
+        _set_armed(rule, false);
+    }
+    return interested;
 }
 
 //! \param[in] timeout_ms is the timeout value passed to [poll(2)](\ref man2::poll); `wait_next_event`
@@ -52,6 +382,13 @@ void EventLoop::add_rule(const FileDescriptor &fd,
 //!
 //! Otherwise, this function returns Result::Success.
 //!
+//! An EventLoop constructed with Backend::Epoll or Backend::IoUring calls Rule::interest and checks
+//! for EOF less often; see the EventLoop class documentation.
+//!
+//! While timers are pending, the wait ends no later than the nearest deadline, and the expired timers
+//! are run after the ready fds' callbacks. If no fd was ready and no timer expired, the wait resumes
+//! for what is left of `timeout_ms`, so a Result::Timeout still means that all of it has passed.
+//!
 //! \b IMPORTANT: every call to Rule::callback must read from or write to Rule::fd, or the `interest`
 //! callback must stop returning true after the callback completes.
 //! If none of these conditions occur, EventLoop::wait_next_event will throw std::runtime_error. This is
@@ -59,6 +396,49 @@ void EventLoop::add_rule(const FileDescriptor &fd,
 //! will result in a busy loop (poll returns on a ready file descriptor; file descriptor is not read or
 //! written, so it is still ready; the next call to poll will immediately return).
 EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
+    const uint64_t start = timestamp_ms();
+    while (true) {
+        // wait no longer than until the nearest deadline (for one far off, the wheel gives an earlier time)
+        int wait_ms = timeout_ms;
+        const auto deadline = _timers.next_deadline();
+        if (deadline.has_value()) {
+            const uint64_t now = timestamp_ms();
+            const auto until_deadline = int(min(*deadline - min(*deadline, now), uint64_t(INT_MAX)));
+            const auto remaining = timeout_ms - int(min(now - start, uint64_t(max(timeout_ms, 0))));
+            wait_ms = timeout_ms < 0 ? until_deadline : min(until_deadline, remaining);
+        }
+
+        Result result;
+        switch (_backend) {
+            case Backend::Epoll:
+                result = _wait_epoll(wait_ms);
+                break;
+            case Backend::IoUring:
+                result = _wait_io_uring(wait_ms);
+                break;
+            default:
+                result = _wait_poll(wait_ms);
+        }
+
+        const size_t expired = _timers.advance(timestamp_ms());
+        if (result != Result::Timeout) {
+            return result;
+        }
+        if (expired > 0) {
+            return Result::Success;
+        }
+        if (timeout_ms >= 0 and timestamp_ms() - start >= uint64_t(timeout_ms)) {
+            return Result::Timeout;
+        }
+    }
+}
+
+EventLoop::Result EventLoop::_wait_poll(const int timeout_ms) {
+    // the rules take turns at being run first
+    if (_rules.size() > 1) {
+        _rules.splice(_rules.end(), _rules, _rules.begin());
+    }
+
     vector<pollfd> pollfds{};
     pollfds.reserve(_rules.size());
     bool something_to_poll = false;
@@ -88,8 +468,8 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
         ++it;
     }
 
-    // quit if there is nothing left to poll
-    if (not something_to_poll) {
+    // quit if there is nothing left to poll or to wait for
+    if (not something_to_poll and _timers.empty()) {
         return Result::Exit;
     }
 
@@ -121,6 +501,10 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
             // if we asked for the status, and the _only_ condition was a hangup, this FD is defunct:
             //   - if it was POLLIN and nothing is readable, no more will ever be readable
             //   - if it was POLLOUT, it will not be writable again
+            // A receive rule reads fd itself, so it records the EOF that its read would have found.
+            if (this_rule.receive) {
+                it->fd.set_eof();
+            }
             this_rule.cancel();
             it = _rules.erase(it);
             continue;
@@ -129,6 +513,7 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
         if (poll_ready) {
             // we only want to call callback if revents includes the event we asked for
             const auto count_before = this_rule.service_count();
+            this_rule.counters->callbacks += not this_rule.receive;
             this_rule.callback();
 
             // only check for busy wait if we're not canceling or exiting
@@ -143,3 +528,133 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
 
     return Result::Success;
 }
+
+EventLoop::Result EventLoop::_wait_epoll(const int timeout_ms) {
+    _prepare_wait();
+
+    // quit if there is nothing left to wait for
+    if (not _something_to_wait_for()) {
+        return Result::Exit;
+    }
+
+    int ready = 0;
+    try {
+        ready = SystemCall("epoll_wait", ::epoll_wait(_epoll->fd_num(), _events.data(), _events.size(), timeout_ms));
+    } catch (unix_error const &e) {
+        if (e.code().value() == EINTR) {
+            return Result::Exit;
+        }
+        throw;
+    }
+    if (ready == 0) {
+        return Result::Timeout;
+    }
+
+    // the ready fds take turns at being run first
+    const size_t first = _rotation++;
+    for (int i = 0; i < ready; ++i) {
+        const epoll_event &event = _events[(first + i) % ready];
+        const auto it = _registrations.find(event.data.fd);
+        if (it == _registrations.end()) {
+            continue;  // every rule on the fd was canceled by an earlier callback in this batch
+        }
+        if (event.events & EPOLLERR) {
+            throw runtime_error("EventLoop: error on polled file descriptor");
+        }
+
+        // callbacks may cancel rules on this fd, so walk a copy
+        for (const RuleIterator rule : vector<RuleIterator>(it->second.rules)) {
+            // like poll, a hangup on an fd no rule is interested in is ignored; and an fd closed by an
+            // earlier callback is left for the next wait to cancel
+            if (rule->armed and not rule->fd.closed()) {
+                _run_rule(rule, event.events);
+            }
+        }
+    }
+
+    // a full batch suggests more fds were ready than there was room for
+    if (size_t(ready) == _events.size()) {
+        _events.resize(2 * _events.size());
+    }
+
+    return Result::Success;
+}
+
+EventLoop::Result EventLoop::_wait_io_uring([[maybe_unused]] const int timeout_ms) {
+#ifdef SPONGE_IO_URING
+    _prepare_wait();
+
+    // quit if there is nothing left to wait for
+    if (not _something_to_wait_for()) {
+        return Result::Exit;
+    }
+
+    // one system call submits every poll and receive queued since the last wait, and waits
+    try {
+        _uring->submit_and_wait(timeout_ms);
+    } catch (unix_error const &e) {
+        if (e.code().value() == EINTR) {
+            return Result::Exit;
+        }
+        throw;
+    }
+
+    bool something_ran = false;
+    IoUring::Completion completion{};
+    while (_uring->next_completion(completion)) {
+        const bool has_buffer = completion.flags & IORING_CQE_F_BUFFER;
+        const auto buffer_id = uint16_t(completion.flags >> IORING_CQE_BUFFER_SHIFT);
+        const auto it = _rule_ids.find(completion.user_data);
+        if (it == _rule_ids.end()) {
+            // a cancellation, or the last completions of a canceled rule
+            if (has_buffer) {
+                _uring->recycle_buffer(buffer_id);
+            }
+            continue;
+        }
+
+        const RuleIterator rule = it->second;
+        something_ran = true;
+        if (not rule->receive) {
+            if (completion.result < 0) {
+                throw unix_error("io_uring poll", -completion.result);
+            }
+            if (completion.result & (POLLERR | POLLNVAL)) {
+                throw runtime_error("EventLoop: error on polled file descriptor");
+            }
+            // the poll is one-shot, so a rule that stays armed needs another
+            if (not rule->fd.closed() and _run_rule(rule, completion.result)) {
+                _submit(rule);
+            }
+            continue;
+        }
+
+        if (completion.result == 0) {
+            // EOF, which the fd records (and tells any other loop watching it) as read() would have
+            rule->fd.set_eof();
+            _cancel_rule(rule);
+            continue;
+        }
+        if (completion.result < 0 and completion.result != -ENOBUFS) {
+            throw unix_error("io_uring receive", -completion.result);
+        }
+        if (has_buffer) {
+            ++rule->counters->callbacks;
+            rule->counters->bytes += completion.result;
+            rule->receive(_uring->buffer(buffer_id, completion.result));
+            _uring->recycle_buffer(buffer_id);
+        }
+
+        // a receive that ran out of buffers, or a one-shot read, needs another; a closed fd cancels the rule
+        if (rule->fd.closed()) {
+            _cancel_rule(rule);
+        } else if (not(completion.flags & IORING_CQE_F_MORE)) {
+            _submit(rule);
+        }
+    }
+
+    return something_ran ? Result::Success : Result::Timeout;
+#else
+    throw runtime_error("EventLoop: built without io_uring");
+#endif
+}
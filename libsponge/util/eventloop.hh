@@ -2,11 +2,21 @@
 #define SPONGE_LIBSPONGE_EVENTLOOP_HH
 
 #include "file_descriptor.hh"
+#include "timer_wheel.hh"
 
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <list>
+#include <memory>
+#include <optional>
 #include <poll.h>
+#include <string_view>
+#include <sys/epoll.h>
+#include <unordered_map>
+#include <vector>
+
+class IoUring;
 
 //! Waits for events on file descriptors and executes corresponding callbacks.
 class EventLoop {
@@ -17,43 +27,172 @@ class EventLoop {
         Out = POLLOUT  //!< Callback will be triggered when Rule::fd is writable.
     };
 
+    //! The kernel interface an EventLoop waits with.
+    enum class Backend {
+        Poll,  //!< Build a pollfd for every rule and call [poll(2)](\ref man2::poll) on every wait.
+        Epoll,  //!< Keep the rules registered with an [epoll(7)](\ref man7::epoll) instance between waits.
+        IoUring  //!< Submit polls and receives to an [io_uring(7)](\ref man7::io_uring) instance in batches.
+    };
+
+    static constexpr size_t RECEIVE_SIZE = 65536;  //!< The most bytes handed to a receive callback at once
+
+    //! \brief How much a receive rule may read from its fd in one wait
+    //! \details Reading stops at whichever limit comes first, or when fd has nothing more to read.
+    //! Both limits must be at least 1.
+    struct Budget {
+        unsigned reads{1};       //!< The most reads
+        size_t bytes{SIZE_MAX};  //!< Stop reading once this many bytes have been read
+    };
+
+    //! \brief Counters for one rule, kept up to date by the loop
+    struct RuleCounters {
+        uint64_t callbacks{0};     //!< Times the rule's callback has run (for a receive rule, times it was given bytes)
+        uint64_t bytes{0};         //!< Bytes given to a receive rule
+        uint64_t budget_spent{0};  //!< Waits in which a receive rule stopped reading because its Budget was spent
+    };
+
+    //! Returned by each call to EventLoop::wait_next_event.
+    enum class Result {
+        Success,  //!< At least one Rule was triggered or timer expired.
+        Timeout,  //!< No rules were triggered and no timers expired before timeout.
+        Exit  //!< All rules were canceled or uninterested and no timer is pending; stop calling wait_next_event.
+    };
+
   private:
     using CallbackT = std::function<void(void)>;  //!< Callback for ready Rule::fd
     using InterestT = std::function<bool(void)>;  //!< `true` return indicates Rule::fd should be polled.
+    using ReceiveCallbackT = std::function<void(std::string_view)>;  //!< Callback for bytes received from Rule::fd
 
     //! \brief Specifies a condition and callback that an EventLoop should handle.
     //! \details Created by calling EventLoop::add_rule() or EventLoop::add_cancelable_rule().
     class Rule {
       public:
-        FileDescriptor fd;    //!< FileDescriptor to monitor for activity.
-        Direction direction;  //!< Direction::In for reading from fd, Direction::Out for writing to fd.
-        CallbackT callback;   //!< A callback that reads or writes fd.
-        InterestT interest;   //!< A callback that returns `true` whenever fd should be polled.
-        CallbackT cancel;     //!< A callback that is called when the rule is cancelled (e.g. on hangup)
+        FileDescriptor fd;           //!< FileDescriptor to monitor for activity.
+        Direction direction;         //!< Direction::In for reading from fd, Direction::Out for writing to fd.
+        CallbackT callback;          //!< A callback that reads or writes fd.
+        InterestT interest;          //!< A callback that returns `true` whenever fd should be polled.
+        CallbackT cancel;            //!< A callback that is called when the rule is cancelled (e.g. on hangup)
+        bool registered{false};      //!< (Backend::Epoll) Whether the rule is in its fd's Registration
+        bool armed{false};           //!< (Backend::Epoll and IoUring) Whether the kernel is watching fd for the rule
+        size_t armed_index{0};       //!< (Backend::Epoll and IoUring) Where an armed rule is in EventLoop::_armed
+        ReceiveCallbackT receive{};  //!< For a receive rule, the callback that is given what was read
+        uint64_t id{0};              //!< (Backend::Epoll and IoUring) The id of the rule, its watch and its submissions
+        bool socket{false};          //!< (Backend::IoUring) Whether fd is a socket
+        Budget budget{};             //!< For a receive rule, how much it may read in one wait
+        //! What the rule has done; shared with whoever added the rule
+        std::shared_ptr<RuleCounters> counters{std::make_shared<RuleCounters>()};
 
         //! Returns the number of times fd has been read or written, depending on the value of Rule::direction.
         //! \details This function is used internally by EventLoop; you will not need to call it
         unsigned int service_count() const;
     };
 
+    using RuleIterator = std::list<Rule>::iterator;
+
+    //! \brief (Backend::Epoll) The rules on one fd, and the events the kernel is watching it for
+    struct Registration {
+        std::vector<RuleIterator> rules{};  //!< Every registered rule on the fd
+        uint32_t events{0};                 //!< The events given in the last epoll_ctl
+        bool added{false};                  //!< Whether the fd has been added to the epoll instance
+    };
+
+    Backend _backend;          //!< How this EventLoop waits
     std::list<Rule> _rules{};  //!< All rules that have been added and not canceled.
+    TimerWheel _timers;        //!< Pending timers, with deadlines in timestamp_ms() time
+
+    //! \name Backend::Epoll state
+    //!@{
+    std::optional<FileDescriptor> _epoll{};                  //!< The epoll instance
+    std::unordered_map<int, Registration> _registrations{};  //!< The registration of each fd number
+    std::vector<RuleIterator> _parked{};                     //!< Rules that are not armed
+    std::vector<RuleIterator> _armed{};                      //!< Rules that are armed, in no particular order
+    std::vector<epoll_event> _events{};                      //!< Room for the events of one wait
+    size_t _rotation{0};                                     //!< Where the next wait starts running the ready fds
+    //!@}
+
+    //! \name Backend::Epoll and Backend::IoUring state
+    //!@{
+    std::unordered_map<uint64_t, RuleIterator> _rule_ids{};  //!< The rule with each id
+    uint64_t _next_id{1};                                    //!< The id of the next rule
+    //! The ids of rules whose fds have been closed or reached EOF since the last wait
+    std::shared_ptr<FileDescriptor::StateChanges> _fd_changes{std::make_shared<FileDescriptor::StateChanges>()};
+    std::vector<uint64_t> _changed{};  //!< Room to take FileDescriptor::StateChanges::changed in
+    //!@}
+
+    //! \name Backend::IoUring state
+    //!@{
+    std::unique_ptr<IoUring> _uring{};  //!< The io_uring instance
+    //!@}
+
+    //! Calls Rule::cancel and deletes the rule
+    void _cancel_rule(const RuleIterator rule);
+
+    //! Bring the kernel's interest in `fd` into line with the rules armed on it
+    void _update_registration(const int fd, Registration &registration);
+
+    //! Arm (or park) `rule` and update its fd's registration
+    void _set_armed(const RuleIterator rule, const bool armed);
+
+    //! Take an armed `rule` out of EventLoop::_armed
+    void _remove_armed(const RuleIterator rule);
+
+    //! (Backend::IoUring) Queue a poll, or for a receive rule a receive, for `rule`
+    void _submit(const RuleIterator rule);
+
+    //! Cancel rules at EOF or closed, and arm parked rules that have become interested
+    void _prepare_wait();
+
+    //! (Backend::Epoll, Backend::IoUring) Whether a timer is pending or an armed rule is still interested
+    bool _something_to_wait_for();
+
+    //! \brief Act on `events` reported for an armed rule
+    //! \returns `true` if the rule is still armed
+    bool _run_rule(const RuleIterator rule, const uint32_t events);
+
+    //! The Backend::Poll implementation of wait_next_event
+    Result _wait_poll(const int timeout_ms);
+
+    //! The Backend::Epoll implementation of wait_next_event
+    Result _wait_epoll(const int timeout_ms);
+
+    //! The Backend::IoUring implementation of wait_next_event
+    Result _wait_io_uring(const int timeout_ms);
 
   public:
-    //! Returned by each call to EventLoop::wait_next_event.
-    enum class Result {
-        Success,  //!< At least one Rule was triggered.
-        Timeout,  //!< No rules were triggered before timeout.
-        Exit  //!< All rules have been canceled or were uninterested; make no further calls to EventLoop::wait_next_event.
-    };
+    //! Construct an EventLoop that waits with `backend`, or with Backend::Epoll if `backend` is unavailable
+    explicit EventLoop(const Backend backend = Backend::Poll);
+
+    ~EventLoop();
+    EventLoop(EventLoop &&other);
+    EventLoop &operator=(EventLoop &&other);
+
+    //! The kernel interface this EventLoop waits with
+    Backend backend() const { return _backend; }
 
     //! Add a rule whose callback will be called when `fd` is ready in the specified Direction.
-    void add_rule(const FileDescriptor &fd,
-                  const Direction direction,
-                  const CallbackT &callback,
-                  const InterestT &interest = [] { return true; },
-                  const CallbackT &cancel = [] {});
+    //! \returns the rule's counters, which stay readable after the rule is canceled
+    std::shared_ptr<const RuleCounters> add_rule(const FileDescriptor &fd,
+                                                 const Direction direction,
+                                                 const CallbackT &callback,
+                                                 const InterestT &interest = [] { return true; },
+                                                 const CallbackT &cancel = [] {});
+
+    //! Add a rule that reads from `fd` whenever it is readable and gives `callback` what was read.
+    //! \returns the rule's counters, which stay readable after the rule is canceled
+    std::shared_ptr<const RuleCounters> add_receive_rule(const FileDescriptor &fd,
+                                                         const ReceiveCallbackT &callback,
+                                                         const CallbackT &cancel = [] {},
+                                                         const Budget &budget = Budget{1, SIZE_MAX});
+
+    //! Call `callback` once, after `delay_ms` milliseconds, from a later wait_next_event()
+    TimerWheel::Handle add_timer(const uint64_t delay_ms, const CallbackT &callback);
 
-    //! Calls [poll(2)](\ref man2::poll) and then executes callback for each ready fd.
+    //! \brief Cancel a timer added by add_timer()
+    //! \returns `true` if the timer was pending, `false` if it has already expired or been canceled
+    bool cancel_timer(const TimerWheel::Handle handle) { return _timers.cancel(handle); }
+
+    //! Calls [poll(2)](\ref man2::poll), [epoll_wait(2)](\ref man2::epoll_wait) or io_uring_enter(2) and then
+    //! executes callback for each ready fd and each expired timer.
     Result wait_next_event(const int timeout_ms);
 };
 
@@ -72,5 +211,38 @@ using Direction = EventLoop::Direction;
 //! A Rule installed using EventLoop::add_cancelable_rule will be polled and canceled under the
 //! same conditions, with the additional condition that if Rule::callback returns `true`, the
 //! Rule will be canceled.
+//!
+//! An EventLoop constructed with Backend::Epoll keeps every fd registered with one epoll instance,
+//! so a wait costs O(ready fds) rather than O(rules). A rule is *armed* (the kernel watches its fd in
+//! its direction) while its interest callback returns `true`, and *parked* otherwise. Parked rules,
+//! and rules added since the last wait, have Rule::interest called on every wait; an armed rule only
+//! has it called when its fd becomes ready, and it is parked then if it has lost interest. Rules are
+//! checked for EOF and closure after their own callbacks run; besides, each rule's fd is watched
+//! (see FileDescriptor::watch), and the next wait checks just the rules whose fds have been closed or
+//! reached EOF since. The loop returns Result::Exit when no armed rule is still interested and no timer
+//! is pending.
+//!
+//! Backend::IoUring is only built when CMake is run with `-DSPONGE_IO_URING=ON`, and an EventLoop
+//! falls back to Backend::Epoll when it is not built or the kernel cannot support it. It treats rules
+//! as Backend::Epoll does, but arms a rule by queueing a one-shot poll, and queued polls are
+//! submitted by the same io_uring_enter(2) that waits for completions. A rule added with
+//! EventLoop::add_receive_rule is armed with a multishot receive (or, if fd is not a socket, a
+//! read) into a ring of buffers registered with the kernel, so a busy fd yields many callbacks
+//! from one system call, none of them reading the fd themselves. The other backends run a receive
+//! rule as a Direction::In rule that reads at most RECEIVE_SIZE bytes each time fd is readable.
+//!
+//! No fd can hold up the others for long. Every ready fd has its callback run once per wait, and
+//! the ready fds take turns at going first: Backend::Poll moves the first rule to the back of the
+//! list on every wait, and Backend::Epoll starts one further into the kernel's list of events.
+//! A receive rule reads again, as long as fd has more, until its Budget is spent; a poll with no
+//! timeout before each further read tells whether it has more, so fd's flags are left alone.
+//! Backend::IoUring instead runs completions in the order the
+//! kernel posted them, and a multishot receive can run at most as far ahead of the others as the
+//! shared ring of buffers allows. Each rule's RuleCounters show how much work it has been given.
+//!
+//! Timers added with EventLoop::add_timer are kept in a TimerWheel, so adding and canceling one
+//! costs O(1) however many are pending. Every backend waits no longer than until the nearest
+//! deadline, and runs the expired timers after the callbacks of the ready fds. A loop with timers
+//! pending does not return Result::Exit, even if no rule is left.
 
 #endif  // SPONGE_LIBSPONGE_EVENTLOOP_HH
@@ -0,0 +1,206 @@
+#include "eventloop_group.hh"
+
+#include "util.hh"
+
+#include <optional>
+#include <sched.h>
+#include <stdexcept>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <utility>
+
+using namespace std;
+
+//! The CPUs the calling thread may run on
+static vector<int> allowed_cpus() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    SystemCall("sched_getaffinity", ::sched_getaffinity(0, sizeof(allowed), &allowed));
+    vector<int> cpus{};
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+EventLoopGroup::TaskQueue::TaskQueue() : _back(new Node), _front(_back.load()) {}
+
+EventLoopGroup::TaskQueue::~TaskQueue() {
+    while (_front != nullptr) {
+        delete exchange(_front, _front->next.load());
+    }
+}
+
+//! \param[in] task is the task to append
+void EventLoopGroup::TaskQueue::push(const TaskT &task) {
+    Node *node = new Node;
+    node->task = task;
+
+    // the exchange orders the producers; until the link is stored, the consumer stops short of the node
+    Node *previous = _back.exchange(node, memory_order_acq_rel);
+    previous->next.store(node, memory_order_release);
+}
+
+//! \param[out] task is set to the oldest task, if there is one
+bool EventLoopGroup::TaskQueue::pop(TaskT &task) {
+    Node *next = _front->next.load(memory_order_acquire);
+    if (next == nullptr) {
+        return false;
+    }
+    task = move(next->task);
+    next->task = nullptr;  // the node becomes the dummy
+    delete exchange(_front, next);
+    return true;
+}
+
+//! \param[in] backend is the kernel interface the loop waits with
+EventLoopGroup::Member::Member(const EventLoop::Backend backend)
+    : loop(backend), wakeup(SystemCall("eventfd", ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))) {
+    // the flag is cleared before the queue is drained, so a task pushed after the drain brings another wakeup
+    loop.add_rule(wakeup, Direction::In, [this] {
+        wakeup.read(sizeof(uint64_t));
+        awake.store(false);
+        TaskT task{};
+        while (tasks.pop(task)) {
+            task(loop);
+        }
+    });
+}
+
+//! \param[in] loops is the number of loops and threads, or 0 for one per CPU this thread may run on
+//! \param[in] backend is the kernel interface every loop waits with
+EventLoopGroup::EventLoopGroup(const size_t loops, const EventLoop::Backend backend) {
+    const size_t count = loops > 0 ? loops : allowed_cpus().size();
+    for (size_t i = 0; i < count; ++i) {
+        _members.push_back(make_unique<Member>(backend));
+    }
+
+    try {
+        for (size_t i = 0; i < count; ++i) {
+            _members[i]->thread = thread(&EventLoopGroup::_run, this, i);
+        }
+    } catch (...) {
+        stop();
+        throw;
+    }
+}
+
+EventLoopGroup::~EventLoopGroup() {
+    try {
+        stop();
+    } catch (...) {
+        // a destructor has no one left to tell
+    }
+}
+
+//! \param[in] index is the CPU to pin to, counting only those the thread may run on
+void EventLoopGroup::_pin(const size_t index) {
+    const vector<int> cpus = allowed_cpus();
+    cpu_set_t cpu;
+    CPU_ZERO(&cpu);
+    CPU_SET(cpus.at(index % cpus.size()), &cpu);
+    SystemCall("sched_setaffinity", ::sched_setaffinity(0, sizeof(cpu), &cpu));
+}
+
+//! \param[in] index is the member whose loop the thread runs
+void EventLoopGroup::_run(const size_t index) {
+    Member &member = *_members[index];
+    try {
+        _pin(index);
+        while (not _stopping.load()) {
+            member.loop.wait_next_event(-1);
+        }
+    } catch (...) {
+        member.failure = current_exception();
+    }
+}
+
+//! \param[in] index is the loop to run the task on
+//! \param[in] task is called with the loop, on the loop's thread
+void EventLoopGroup::post(const size_t index, const TaskT &task) {
+    Member &member = *_members.at(index);
+    member.tasks.push(task);
+
+    // one write to the eventfd covers every task pushed before the loop drains its queue
+    if (not member.awake.exchange(true)) {
+        const uint64_t one = 1;
+        SystemCall("write", int(::write(member.wakeup.fd_num(), &one, sizeof(one))));
+    }
+}
+
+//! \param[in] address is the address to bind to
+//! \param[in] sockets is the list in each member that keeps its socket
+template <typename SocketT>
+Address EventLoopGroup::_shard(const Address &address, list<SocketT> Member::*sockets) {
+    // with port 0, the first socket has the kernel choose a port, and the others join it there
+    optional<Address> bound{};
+    for (const auto &member : _members) {
+        SocketT &socket = ((*member).*sockets).emplace_back();
+        socket.set_reuseport();
+        socket.bind(bound.value_or(address));
+        if (not bound.has_value()) {
+            bound = socket.local_address();
+        }
+    }
+    return bound.value();
+}
+
+//! \param[in] address is the address to listen on
+//! \param[in] on_accept is given each connection, on the thread of the loop whose socket accepted it
+//! \param[in] backlog is the backlog of each loop's socket
+Address EventLoopGroup::listen(const Address &address, const AcceptCallbackT &on_accept, const int backlog) {
+    const Address bound = _shard(address, &Member::listeners);
+    for (size_t i = 0; i < size(); ++i) {
+        TCPSocket &listener = _members[i]->listeners.back();
+        listener.listen(backlog);
+        post(i, [i, &listener, on_accept](EventLoop &loop) {
+            loop.add_rule(listener, Direction::In, [i, &loop, &listener, on_accept] {
+                on_accept(i, loop, listener.accept());
+            });
+        });
+    }
+    return bound;
+}
+
+//! \param[in] address is the address to bind to
+//! \param[in] setup is given each loop's socket, on that loop's thread, to add rules for it
+Address EventLoopGroup::bind_datagrams(const Address &address, const DatagramSetupT &setup) {
+    const Address bound = _shard(address, &Member::datagrams);
+    for (size_t i = 0; i < size(); ++i) {
+        UDPSocket &socket = _members[i]->datagrams.back();
+        post(i, [i, &socket, setup](EventLoop &loop) { setup(i, loop, socket); });
+    }
+    return bound;
+}
+
+void EventLoopGroup::stop() {
+    // a loop's thread cannot join itself, and would leave the group half-stopped trying
+    for (const auto &member : _members) {
+        if (member->thread.get_id() == this_thread::get_id()) {
+            throw runtime_error("EventLoopGroup: stop() called from one of the group's own threads");
+        }
+    }
+
+    if (not _stopped) {
+        // an empty task wakes each loop to see the flag
+        _stopping.store(true);
+        for (size_t i = 0; i < size(); ++i) {
+            post(i, [](EventLoop &) {});
+        }
+        for (const auto &member : _members) {
+            if (member->thread.joinable()) {
+                member->thread.join();
+            }
+        }
+        _stopped = true;
+    }
+
+    // failures are kept, so every call reports them
+    for (const auto &member : _members) {
+        if (member->failure) {
+            rethrow_exception(member->failure);
+        }
+    }
+}
@@ -0,0 +1,125 @@
+#ifndef SPONGE_LIBSPONGE_EVENTLOOP_GROUP_HH
+#define SPONGE_LIBSPONGE_EVENTLOOP_GROUP_HH
+
+#include "address.hh"
+#include "eventloop.hh"
+#include "file_descriptor.hh"
+#include "socket.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <list>
+#include <memory>
+#include <thread>
+#include <vector>
+
+//! \brief Runs EventLoops on threads of their own, one per CPU, and hands work between them
+class EventLoopGroup {
+  public:
+    using TaskT = std::function<void(EventLoop &)>;  //!< Work run on a loop's thread, given its loop
+
+    //! Called on a loop's thread with the loop's index, the loop, and a connection accepted there
+    using AcceptCallbackT = std::function<void(const size_t, EventLoop &, TCPSocket &&)>;
+
+    //! Called on a loop's thread with the loop's index, the loop, and that loop's socket
+    using DatagramSetupT = std::function<void(const size_t, EventLoop &, UDPSocket &)>;
+
+    //! \brief A lock-free queue of tasks that any thread may push to and one thread pops from
+    //! \details A linked list whose producers swap themselves in at the back with one atomic exchange,
+    //! and whose consumer follows the links from the front; the front node is always a spent dummy.
+    class TaskQueue {
+        //! \brief A task and the link to the one pushed after it
+        struct Node {
+            TaskT task{};                       //!< The task (empty in the dummy)
+            std::atomic<Node *> next{nullptr};  //!< The next node, once its producer has linked it
+        };
+
+        std::atomic<Node *> _back;  //!< The node pushed last
+        Node *_front;               //!< The dummy, whose next node is popped next (consumer only)
+
+      public:
+        TaskQueue();
+        ~TaskQueue();
+        TaskQueue(const TaskQueue &) = delete;
+        TaskQueue &operator=(const TaskQueue &) = delete;
+
+        //! Append `task`; safe from any thread
+        void push(const TaskT &task);
+
+        //! \brief Take the oldest task, from the consumer's thread only
+        //! \returns `false` if the queue is empty, or its next task is still being linked in
+        bool pop(TaskT &task);
+    };
+
+  private:
+    //! \brief A loop, its thread, and the queue through which other threads reach it
+    struct Member {
+        EventLoop loop;                       //!< The loop, used only from `thread` once it runs
+        TaskQueue tasks{};                    //!< Tasks for the loop's thread
+        FileDescriptor wakeup;                //!< An eventfd that is written to wake the loop
+        std::atomic<bool> awake{false};       //!< Whether a wakeup is already on its way
+        std::list<TCPSocket> listeners{};     //!< Listening sockets sharded onto this loop
+        std::list<UDPSocket> datagrams{};     //!< Datagram sockets sharded onto this loop
+        std::exception_ptr failure{nullptr};  //!< What ended the thread, if it threw
+        std::thread thread{};                 //!< The thread that runs the loop
+
+        explicit Member(const EventLoop::Backend backend);
+    };
+
+    std::vector<std::unique_ptr<Member>> _members{};  //!< One per loop
+    std::atomic<bool> _stopping{false};                //!< Set by stop() to end every thread
+    bool _stopped{false};                              //!< Whether the threads have been joined
+
+    //! The body of member `index`'s thread
+    void _run(const size_t index);
+
+    //! Pin the calling thread to the `index`th CPU it is allowed to run on (modulo their number)
+    static void _pin(const size_t index);
+
+    //! Bind one socket per loop to `address` with SO_REUSEPORT, and return the address they share
+    template <typename SocketT>
+    Address _shard(const Address &address, std::list<SocketT> Member::*sockets);
+
+  public:
+    //! \brief Start `loops` threads (by default one per CPU), each running an EventLoop with `backend`
+    explicit EventLoopGroup(const size_t loops = 0, const EventLoop::Backend backend = EventLoop::Backend::Epoll);
+
+    //! Stop and join the threads, ignoring any exception they ended with
+    ~EventLoopGroup();
+
+    EventLoopGroup(const EventLoopGroup &) = delete;
+    EventLoopGroup &operator=(const EventLoopGroup &) = delete;
+
+    //! Number of loops
+    size_t size() const { return _members.size(); }
+
+    //! \brief Run `task` on loop `index`'s thread, at its next wait; safe from any thread
+    void post(const size_t index, const TaskT &task);
+
+    //! \brief Listen on `address` with one socket per loop, so the kernel spreads connections across loops
+    //! \returns the address listened on (which has the port chosen, if `address` had port 0)
+    Address listen(const Address &address, const AcceptCallbackT &on_accept, const int backlog = 128);
+
+    //! \brief Bind one UDP socket per loop to `address`, so the kernel spreads flows across loops
+    //! \returns the address bound (which has the port chosen, if `address` had port 0)
+    Address bind_datagrams(const Address &address, const DatagramSetupT &setup);
+
+    //! \brief Stop every loop and join its thread; from any thread but the group's own
+    //! \details Rethrows the first exception that a loop's thread ended with, on this call and any later one.
+    void stop();
+};
+
+//! \class EventLoopGroup
+//! An EventLoop is not thread-safe, so each loop of a group is touched only by its own thread,
+//! which is pinned to a CPU. Other threads reach a loop by posting a task to it: the task goes
+//! on the loop's TaskQueue, and, unless a wakeup is already pending, an eventfd that the loop
+//! has a rule on is written to end its wait. A loop's tasks run in the order they were posted.
+//!
+//! listen() and bind_datagrams() shard a server across the loops. Each loop gets its own socket,
+//! bound to the same address with SO_REUSEPORT, and the kernel hashes each connection or flow to
+//! one of them, so a connection lives on one loop and no locks are taken on its path.
+//! Sockets made this way live as long as the group; connections are the accept callback's to keep.
+
+#endif  // SPONGE_LIBSPONGE_EVENTLOOP_GROUP_HH
@@ -21,6 +21,25 @@ FileDescriptor::FDWrapper::FDWrapper(const int fd) : _fd(fd) {
 void FileDescriptor::FDWrapper::close() {
     SystemCall("close", ::close(_fd));
     _eof = _closed = true;
+    state_changed();
+}
+
+void FileDescriptor::FDWrapper::state_changed() {
+    const lock_guard<mutex> watches_lock(_watches_mutex);
+    for (const auto &[watch, id] : _watches) {
+        if (const auto changes = watch.lock()) {
+            // a StateChanges mutex is only ever taken inside a watches mutex, never the other way round
+            const lock_guard<mutex> lock(changes->mutex);
+            changes->changed.push_back(id);
+        }
+    }
+}
+
+void FileDescriptor::FDWrapper::reached_eof() {
+    if (not _eof) {
+        _eof = true;
+        state_changed();
+    }
 }
 
 FileDescriptor::FDWrapper::~FDWrapper() {
@@ -44,6 +63,28 @@ FileDescriptor::FileDescriptor(shared_ptr<FDWrapper> other_shared_ptr) : _intern
 //! \returns a copy of this FileDescriptor
 FileDescriptor FileDescriptor::duplicate() const { return FileDescriptor(_internal_fd); }
 
+//! \param[in] changes is where to report the change of state
+//! \param[in] id is what to report it as
+void FileDescriptor::watch(const shared_ptr<StateChanges> &changes, const uint64_t id) {
+    // watches left by a watcher that no longer exists are dropped here
+    const lock_guard<mutex> lock(_internal_fd->_watches_mutex);
+    auto &watches = _internal_fd->_watches;
+    watches.erase(remove_if(watches.begin(), watches.end(), [](const auto &w) { return w.first.expired(); }),
+                  watches.end());
+    watches.emplace_back(changes, id);
+}
+
+//! \param[in] changes is what was passed to watch()
+//! \param[in] id is what was passed to watch()
+void FileDescriptor::unwatch(const StateChanges &changes, const uint64_t id) {
+    const lock_guard<mutex> lock(_internal_fd->_watches_mutex);
+    auto &watches = _internal_fd->_watches;
+    watches.erase(remove_if(watches.begin(),
+                            watches.end(),
+                            [&](const auto &w) { return w.second == id and w.first.lock().get() == &changes; }),
+                  watches.end());
+}
+
 //! \param[in] limit is the maximum number of bytes to read; fewer bytes may be returned
 //! \param[out] str is the string to be read
 void FileDescriptor::read(std::string &str, const size_t limit) {
@@ -53,7 +94,7 @@ void FileDescriptor::read(std::string &str, const size_t limit) {
 
     ssize_t bytes_read = SystemCall("read", ::read(fd_num(), str.data(), size_to_read));
     if (limit > 0 && bytes_read == 0) {
-        _internal_fd->_eof = true;
+        _internal_fd->reached_eof();
     }
     if (bytes_read > static_cast<ssize_t>(size_to_read)) {
         throw runtime_error("read() read more than requested");
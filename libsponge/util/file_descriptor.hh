@@ -5,11 +5,24 @@
 
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <limits>
 #include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 //! A reference-counted handle to a file descriptor
 class FileDescriptor {
+  public:
+    //! \brief Where a FileDescriptor reports that it has been closed or has reached EOF
+    //! \details EventLoop watches the fds of its rules with one, so it need only look at their rules.
+    struct StateChanges {
+        std::mutex mutex{};               //!< Guards StateChanges::changed, as an fd may change state on any thread
+        std::vector<uint64_t> changed{};  //!< The ids of the watches whose fd has changed state
+    };
+
+  private:
     //! \brief A handle on a kernel file descriptor.
     //! \details FileDescriptor objects contain a std::shared_ptr to a FDWrapper.
     class FDWrapper {
@@ -19,6 +32,10 @@ class FileDescriptor {
         bool _closed = false;       //!< Flag indicating whether FDWrapper::_fd has been closed
         unsigned _read_count = 0;   //!< The number of times FDWrapper::_fd has been read
         unsigned _write_count = 0;  //!< The numberof times FDWrapper::_fd has been written
+        //! Where to report that FDWrapper::_fd has been closed or reached EOF, and under which ids
+        std::vector<std::pair<std::weak_ptr<StateChanges>, uint64_t>> _watches{};
+        //! Guards FDWrapper::_watches, which a loop may change while another thread closes or reads the fd
+        std::mutex _watches_mutex{};
 
         //! Construct from a file descriptor number returned by the kernel
         explicit FDWrapper(const int fd);
@@ -26,6 +43,10 @@ class FileDescriptor {
         ~FDWrapper();
         //! Calls [close(2)](\ref man2::close) on FDWrapper::_fd
         void close();
+        //! Tells each watch that FDWrapper::_fd has been closed or reached EOF
+        void state_changed();
+        //! Sets FDWrapper::_eof, telling each watch if it was not already set
+        void reached_eof();
 
         //! \name
         //! An FDWrapper cannot be copied or moved
@@ -98,6 +119,15 @@ class FileDescriptor {
     unsigned int write_count() const { return _internal_fd->_write_count; }
     //!@}
 
+    //! Record that the fd has reached EOF, for a reader that does not go through read() (e.g. io_uring)
+    void set_eof() { _internal_fd->reached_eof(); }
+
+    //! Report to `changes` under `id` when the fd is closed or reaches EOF, until unwatch() is called
+    void watch(const std::shared_ptr<StateChanges> &changes, const uint64_t id);
+
+    //! Stop a watch started by watch()
+    void unwatch(const StateChanges &changes, const uint64_t id);
+
     //! \name Copy/move constructor/assignment operators
     //! FileDescriptor can be moved, but cannot be copied (but see duplicate())
     //!@{
@@ -0,0 +1,68 @@
+#include "interval_set.hh"
+
+#include <algorithm>
+#include <iterator>
+
+using namespace std;
+
+//! \param[in] begin is the first index to add
+//! \param[in] end is one past the last index to add
+void IntervalSet::insert(uint64_t begin, uint64_t end) {
+    if (begin >= end) {
+        return;
+    }
+
+    // start from the interval that begins at or before `begin`, if it reaches `begin`
+    auto it = _intervals.upper_bound(begin);
+    if (it != _intervals.begin() and prev(it)->second >= begin) {
+        --it;
+    }
+
+    // absorb every interval that overlaps or touches [begin, end)
+    while (it != _intervals.end() and it->first <= end) {
+        begin = min(begin, it->first);
+        end = max(end, it->second);
+        _size -= it->second - it->first;
+        it = _intervals.erase(it);
+    }
+
+    _intervals.emplace_hint(it, begin, end);
+    _size += end - begin;
+}
+
+//! \param[in] index is the smallest index that stays in the set
+void IntervalSet::erase_below(const uint64_t index) {
+    while (not _intervals.empty() and _intervals.begin()->first < index) {
+        auto first = _intervals.begin();
+        if (first->second <= index) {
+            _size -= first->second - first->first;
+            _intervals.erase(first);
+            continue;
+        }
+
+        // the interval straddles `index`: re-key it without reallocating the node
+        _size -= index - first->first;
+        auto node = _intervals.extract(first);
+        node.key() = index;
+        _intervals.insert(move(node));
+    }
+}
+
+//! \param[in] index is where the run of members starts
+uint64_t IntervalSet::contiguous_end(const uint64_t index) const {
+    auto it = _intervals.upper_bound(index);
+    if (it == _intervals.begin()) {
+        return index;
+    }
+    --it;
+    return it->second > index ? it->second : index;
+}
+
+//! \param[in] index is the member whose interval is wanted
+pair<uint64_t, uint64_t> IntervalSet::interval_containing(const uint64_t index) const {
+    auto it = _intervals.upper_bound(index);
+    if (it == _intervals.begin() or prev(it)->second <= index) {
+        return {index, index};
+    }
+    return *prev(it);
+}
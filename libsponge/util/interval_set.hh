@@ -0,0 +1,43 @@
+#ifndef SPONGE_LIBSPONGE_INTERVAL_SET_HH
+#define SPONGE_LIBSPONGE_INTERVAL_SET_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+
+//! \brief A set of 64-bit indices, stored as sorted, non-overlapping, half-open intervals
+//! \details Inserting an interval merges it with every interval it overlaps or touches,
+//! so the set always holds the fewest intervals that cover its members. The number of
+//! covered indices is maintained on every update, so size() is O(1).
+class IntervalSet {
+  private:
+    std::map<uint64_t, uint64_t> _intervals{};  //!< Maps the first index of each interval to one past its last
+    size_t _size{0};                            //!< Total number of indices covered by the intervals
+
+  public:
+    //! \brief Add the indices in [`begin`, `end`) to the set
+    void insert(uint64_t begin, uint64_t end);
+
+    //! \brief Remove every index below `index` from the set
+    void erase_below(const uint64_t index);
+
+    //! \returns one past the last index of the run of members that starts at `index`,
+    //! or `index` itself if it is not a member
+    uint64_t contiguous_end(const uint64_t index) const;
+
+    //! \returns the interval [`begin`, `end`) that holds `index`,
+    //! or an empty interval at `index` if it is not a member
+    std::pair<uint64_t, uint64_t> interval_containing(const uint64_t index) const;
+
+    //! \brief Number of indices in the set
+    size_t size() const { return _size; }
+
+    //! \brief Whether the set has no members
+    bool empty() const { return _intervals.empty(); }
+
+    //! \brief Access the underlying intervals, keyed by their first index
+    const std::map<uint64_t, uint64_t> &intervals() const { return _intervals; }
+};
+
+#endif  // SPONGE_LIBSPONGE_INTERVAL_SET_HH
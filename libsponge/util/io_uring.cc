@@ -0,0 +1,161 @@
+#include "io_uring.hh"
+
+#include "util.hh"
+
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+//! Calls io_uring_setup(2), checking that the kernel has the features IoUring needs
+static int setup(const unsigned entries, io_uring_params &params) {
+    const int fd = SystemCall("io_uring_setup", int(::syscall(__NR_io_uring_setup, entries, &params)));
+    constexpr uint32_t needed = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if ((params.features & needed) != needed) {
+        ::close(fd);
+        throw runtime_error("io_uring_setup: kernel lacks single mmap, no-drop or extended arguments");
+    }
+    return fd;
+}
+
+//! The length of the mapping that holds both rings
+static size_t rings_length(const io_uring_params &params) {
+    return max(params.sq_off.array + params.sq_entries * sizeof(uint32_t),
+               params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+}
+
+IoUring::Mapping::Mapping(const size_t length, const int fd, const off_t offset)
+    : _address(nullptr), _length(length) {
+    const int flags = fd < 0 ? MAP_PRIVATE | MAP_ANONYMOUS : MAP_SHARED | MAP_POPULATE;
+    void *address = ::mmap(nullptr, _length, PROT_READ | PROT_WRITE, flags, fd, offset);
+    if (address == MAP_FAILED) {
+        throw unix_error("mmap");
+    }
+    _address = static_cast<char *>(address);
+}
+
+IoUring::Mapping::~Mapping() { ::munmap(_address, _length); }
+
+//! \param[in] entries is the number of submissions that can be queued before the queue is flushed
+//! \param[in] buffer_count is the number of provided buffers, a power of two
+//! \param[in] buffer_size is the size of each provided buffer
+IoUring::IoUring(const unsigned entries, const uint16_t buffer_count, const uint32_t buffer_size)
+    : _fd(setup(entries, _params))
+    , _rings(rings_length(_params), _fd.fd_num(), IORING_OFF_SQ_RING)
+    , _sqes(_params.sq_entries * sizeof(io_uring_sqe), _fd.fd_num(), IORING_OFF_SQES)
+    , _buffer_ring(buffer_count * sizeof(io_uring_buf), -1, 0)
+    , _buffers(size_t(buffer_count) * buffer_size, -1, 0)
+    , _buffer_count(buffer_count)
+    , _buffer_size(buffer_size) {
+    if (buffer_count == 0 or (buffer_count & (buffer_count - 1))) {
+        throw runtime_error("IoUring: the number of buffers must be a power of two");
+    }
+
+    // the submission queue's index array maps each slot to the entry of the same number, once and for all
+    uint32_t *array = _rings.at<uint32_t>(_params.sq_off.array);
+    for (uint32_t i = 0; i < _params.sq_entries; ++i) {
+        array[i] = i;
+    }
+
+    io_uring_buf_reg registration{};
+    registration.ring_addr = uint64_t(_buffer_ring.at<io_uring_buf>(0));
+    registration.ring_entries = buffer_count;
+    registration.bgid = BUFFER_GROUP;
+    SystemCall("io_uring_register",
+               int(::syscall(__NR_io_uring_register, _fd.fd_num(), IORING_REGISTER_PBUF_RING, &registration, 1)));
+    for (uint16_t id = 0; id < buffer_count; ++id) {
+        recycle_buffer(id);
+    }
+}
+
+IoUring::~IoUring() {
+    io_uring_buf_reg registration{};
+    registration.bgid = BUFFER_GROUP;
+    ::syscall(__NR_io_uring_register, _fd.fd_num(), IORING_UNREGISTER_PBUF_RING, &registration, 1);
+}
+
+int IoUring::_enter(const unsigned min_complete, const unsigned flags, const void *arg, const size_t arg_size) {
+    const int submitted = SystemCall(
+        "io_uring_enter",
+        int(::syscall(__NR_io_uring_enter, _fd.fd_num(), _unsubmitted, min_complete, flags, arg, arg_size)),
+        ETIME);
+    if (submitted > 0) {
+        _unsubmitted -= min(_unsubmitted, unsigned(submitted));
+    }
+    return submitted;
+}
+
+//! \param[in] opcode is the IORING_OP_* operation
+//! \param[in] fd is the file descriptor to operate on
+//! \param[in] user_data is returned in the operation's completions
+io_uring_sqe &IoUring::prepare(const uint8_t opcode, const int fd, const uint64_t user_data) {
+    const uint32_t head = __atomic_load_n(_rings.at<uint32_t>(_params.sq_off.head), __ATOMIC_ACQUIRE);
+    uint32_t *tail = _rings.at<uint32_t>(_params.sq_off.tail);
+    if (*tail - head == _params.sq_entries) {
+        _enter(0, 0, nullptr, 0);
+    }
+
+    io_uring_sqe &sqe = _sqes.at<io_uring_sqe>(0)[*tail & *_rings.at<uint32_t>(_params.sq_off.ring_mask)];
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = opcode;
+    sqe.fd = fd;
+    sqe.user_data = user_data;
+
+    // the kernel reads the entry only after it sees the new tail, and only when it is next entered
+    __atomic_store_n(tail, *tail + 1, __ATOMIC_RELEASE);
+    ++_unsubmitted;
+    return sqe;
+}
+
+//! \param[in] timeout_ms is the longest to wait for a completion, or negative to wait for one indefinitely
+void IoUring::submit_and_wait(const int timeout_ms) {
+    // even without waiting, entering with GETEVENTS runs the task work that posts pending completions
+    if (timeout_ms == 0) {
+        _enter(0, IORING_ENTER_GETEVENTS, nullptr, 0);
+        return;
+    }
+    if (timeout_ms < 0) {
+        _enter(1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        return;
+    }
+
+    __kernel_timespec timeout{};
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (timeout_ms % 1000) * 1000000LL;
+    io_uring_getevents_arg arg{};
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = uint64_t(&timeout);
+    _enter(1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+}
+
+//! \param[out] completion is set to the oldest completion, if there is one
+bool IoUring::next_completion(Completion &completion) {
+    uint32_t *head = _rings.at<uint32_t>(_params.cq_off.head);
+    const uint32_t tail = __atomic_load_n(_rings.at<uint32_t>(_params.cq_off.tail), __ATOMIC_ACQUIRE);
+    if (*head == tail) {
+        return false;
+    }
+
+    const io_uring_cqe &cqe =
+        _rings.at<io_uring_cqe>(_params.cq_off.cqes)[*head & *_rings.at<uint32_t>(_params.cq_off.ring_mask)];
+    completion = {cqe.user_data, cqe.res, cqe.flags};
+    __atomic_store_n(head, *head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+//! \param[in] id is the buffer named by a completion's flags
+void IoUring::recycle_buffer(const uint16_t id) {
+    io_uring_buf &entry = _buffer_ring.at<io_uring_buf>(0)[_buffer_tail & (_buffer_count - 1)];
+    entry.addr = uint64_t(_buffers.at<char>(size_t(id) * _buffer_size));
+    entry.len = _buffer_size;
+    entry.bid = id;
+
+    // the ring's tail overlays the `resv` field of its first entry
+    ++_buffer_tail;
+    __atomic_store_n(&_buffer_ring.at<io_uring_buf>(0)->resv, _buffer_tail, __ATOMIC_RELEASE);
+}
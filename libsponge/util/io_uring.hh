@@ -0,0 +1,98 @@
+#ifndef SPONGE_LIBSPONGE_IO_URING_HH
+#define SPONGE_LIBSPONGE_IO_URING_HH
+
+#include "file_descriptor.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <string_view>
+#include <sys/types.h>
+
+//! \brief An [io_uring(7)](\ref man7::io_uring) instance, driven through the raw system calls
+//! \details Submissions are queued with prepare() and handed to the kernel by the next call to
+//! submit_and_wait(), so a whole batch of them and the wait for completions cost one
+//! io_uring_enter(2). Completions are then taken one at a time with next_completion().
+//!
+//! The instance also owns a ring of provided buffers in buffer group BUFFER_GROUP. A receive
+//! submitted with IOSQE_BUFFER_SELECT picks a free buffer itself; its completion names the buffer,
+//! and the buffer must be handed back with recycle_buffer() once its contents have been used.
+//!
+//! Construction throws if the kernel lacks io_uring or any feature this class relies on.
+class IoUring {
+  public:
+    static constexpr uint16_t BUFFER_GROUP = 0;  //!< The buffer group of the provided buffers
+
+    //! \brief A completion, copied out of the completion queue
+    struct Completion {
+        uint64_t user_data;  //!< The user data of the submission that completed
+        int32_t result;      //!< The result of the operation, or minus an errno value
+        uint32_t flags;      //!< IORING_CQE_F_* flags
+    };
+
+  private:
+    //! \brief A region of memory from [mmap(2)](\ref man2::mmap), unmapped on destruction
+    class Mapping {
+        char *_address;  //!< Start of the region
+        size_t _length;  //!< Length of the region
+
+      public:
+        //! Map `length` bytes of `fd` (or anonymous memory if `fd` is -1) at `offset`
+        Mapping(const size_t length, const int fd, const off_t offset);
+        ~Mapping();
+
+        Mapping(const Mapping &other) = delete;
+        Mapping &operator=(const Mapping &other) = delete;
+
+        //! The object at `offset` bytes into the region
+        template <typename T>
+        T *at(const size_t offset) const {
+            return reinterpret_cast<T *>(_address + offset);
+        }
+    };
+
+    io_uring_params _params{};  //!< What io_uring_setup(2) reported
+    FileDescriptor _fd;         //!< The io_uring instance
+    Mapping _rings;             //!< The submission and completion rings, in one mapping
+    Mapping _sqes;              //!< The submission queue entries
+    Mapping _buffer_ring;       //!< The ring of provided buffers shared with the kernel
+    Mapping _buffers;           //!< The memory of the provided buffers
+    uint16_t _buffer_count;     //!< Number of provided buffers, a power of two
+    uint32_t _buffer_size;      //!< Size of each provided buffer
+    uint16_t _buffer_tail{0};   //!< Our copy of the buffer ring's tail
+    unsigned _unsubmitted{0};   //!< Entries prepared since the last submission
+
+    //! Calls io_uring_enter(2), giving it every prepared entry
+    int _enter(const unsigned min_complete, const unsigned flags, const void *arg, const size_t arg_size);
+
+  public:
+    //! Set up an instance with room for `entries` submissions and `buffer_count` buffers of `buffer_size` bytes
+    IoUring(const unsigned entries, const uint16_t buffer_count, const uint32_t buffer_size);
+
+    //! Take the provided buffers back from the kernel before their memory is unmapped
+    ~IoUring();
+
+    IoUring(const IoUring &other) = delete;
+    IoUring &operator=(const IoUring &other) = delete;
+
+    //! \brief A cleared submission queue entry for `opcode` on `fd`, tagged with `user_data`
+    //! \details If the submission queue is full, the entries already in it are submitted first.
+    io_uring_sqe &prepare(const uint8_t opcode, const int fd, const uint64_t user_data);
+
+    //! \brief Submit the prepared entries, then wait up to `timeout_ms` for at least one completion
+    //! \details A negative timeout waits indefinitely; a zero timeout collects completions without waiting.
+    void submit_and_wait(const int timeout_ms);
+
+    //! Take the oldest completion, returning `false` if there is none
+    bool next_completion(Completion &completion);
+
+    //! The first `length` bytes of provided buffer `id`
+    std::string_view buffer(const uint16_t id, const size_t length) const {
+        return {_buffers.at<const char>(size_t(id) * _buffer_size), length};
+    }
+
+    //! Hand provided buffer `id` back to the kernel
+    void recycle_buffer(const uint16_t id);
+};
+
+#endif  // SPONGE_LIBSPONGE_IO_URING_HH
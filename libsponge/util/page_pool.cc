@@ -0,0 +1,68 @@
+#include "page_pool.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+// The size class for a block of `size` bytes: the base-2 logarithm of its size in pages, rounded up.
+// A block too large for any class gets SIZE_CLASSES.
+static size_t size_class(const size_t size) {
+    const size_t pages = (size + PagePool::PAGE_SIZE - 1) / PagePool::PAGE_SIZE;
+    if (pages <= 1) {
+        return 0;
+    }
+    return min(size_t(64 - __builtin_clzll(pages - 1)), PagePool::SIZE_CLASSES);
+}
+
+// The number of pages in a block of `size` bytes from class `size_class`
+static size_t block_pages(const size_t size, const size_t size_class) {
+    if (size_class < PagePool::SIZE_CLASSES) {
+        return size_t(1) << size_class;
+    }
+    return (size + PagePool::PAGE_SIZE - 1) / PagePool::PAGE_SIZE;
+}
+
+PagePool::~PagePool() {
+    for (auto &blocks : _free) {
+        for (char *block : blocks) {
+            delete[] block;
+        }
+    }
+}
+
+//! \param[in] size is the number of bytes needed
+char *PagePool::allocate(const size_t size) {
+    const size_t cls = size_class(size);
+    const size_t pages = block_pages(size, cls);
+    _stats.pages_in_use += pages;
+    _stats.high_water_mark = max(_stats.high_water_mark, _stats.pages_in_use);
+
+    if (cls < SIZE_CLASSES and not _free[cls].empty()) {
+        char *block = _free[cls].back();
+        _free[cls].pop_back();
+        _stats.free_pages -= pages;
+        return block;
+    }
+    _stats.heap_pages += pages;
+    return new char[pages * PAGE_SIZE];
+}
+
+//! \param[in] block must have come from allocate() on this pool
+//! \param[in] size must be the size that `block` was allocated with
+void PagePool::deallocate(char *block, const size_t size) {
+    const size_t cls = size_class(size);
+    const size_t pages = block_pages(size, cls);
+    _stats.pages_in_use -= pages;
+
+    if (cls < SIZE_CLASSES and _stats.free_pages + pages <= _max_free_pages) {
+        _free[cls].push_back(block);
+        _stats.free_pages += pages;
+        return;
+    }
+    delete[] block;
+}
+
+PagePool &PagePool::local() {
+    thread_local PagePool pool;
+    return pool;
+}
@@ -0,0 +1,72 @@
+#ifndef SPONGE_LIBSPONGE_PAGE_POOL_HH
+#define SPONGE_LIBSPONGE_PAGE_POOL_HH
+
+#include "allocator.hh"
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+//! \brief A slab allocator that recycles blocks of whole pages rather than handing them back to the heap
+//! \details Blocks come in size classes of 1, 2, 4, ... pages, up to MAX_BLOCK_SIZE; a request is
+//! rounded up to the smallest class that holds it, and larger requests go straight to the heap.
+//! Blocks given back are kept on a free list per class (up to `max_free_pages` pages in all) and
+//! handed out again by allocate(), so storage that comes and goes with reordering or connection
+//! churn does not turn into malloc/free traffic.
+//!
+//! Because the classes are powers of two, a request just over a class boundary takes up to twice
+//! the memory it asked for: a ring of 64 KB + 7 bytes (17 pages) gets a 32-page block. Capacities
+//! that are a power-of-two number of pages (or use power_of_two_storage) waste nothing.
+//!
+//! A pool is not thread-safe: each thread uses its own through local(), and an object that holds
+//! blocks from it must be destroyed on that thread, before the thread exits. Nothing uses a pool
+//! unless asked to; the default Allocator is HeapAllocator.
+class PagePool : public Allocator {
+  public:
+    static constexpr size_t SIZE_CLASSES = 9;                                 //!< 1 page up to 256 pages
+    static constexpr size_t MAX_BLOCK_SIZE = PAGE_SIZE << (SIZE_CLASSES - 1);  //!< Largest block kept (1 MB)
+    static constexpr size_t DEFAULT_MAX_FREE_PAGES = 1024;                    //!< Free pages kept by default (4 MB)
+
+    //! \brief Counters for a pool, all in pages
+    struct Stats {
+        size_t pages_in_use;     //!< Pages in blocks handed out and not yet given back
+        size_t high_water_mark;  //!< The most pages that have been in use at once
+        size_t free_pages;       //!< Pages in blocks kept for reuse
+        size_t heap_pages;       //!< Pages taken from the heap, because no free block was at hand
+    };
+
+  private:
+    std::array<std::vector<char *>, SIZE_CLASSES> _free{};  //!< Blocks kept for reuse, by size class
+    size_t _max_free_pages;                                  //!< The most pages to keep for reuse
+    Stats _stats{};                                          //!< Counters
+
+  public:
+    //! \brief Construct an empty pool that keeps at most `max_free_pages` pages for reuse
+    explicit PagePool(const size_t max_free_pages = DEFAULT_MAX_FREE_PAGES) : _max_free_pages(max_free_pages) {}
+
+    //! \brief Free the blocks kept for reuse
+    ~PagePool() override;
+
+    PagePool(const PagePool &) = delete;
+    PagePool &operator=(const PagePool &) = delete;
+
+    //! \brief Allocate an uninitialized block of at least `size` bytes, reusing a free block if there is one
+    char *allocate(const size_t size) override;
+
+    //! \brief Give back a block of `size` bytes, keeping it for reuse if there is room
+    void deallocate(char *block, const size_t size) override;
+
+    //! \brief Counters for the pool
+    const Stats &stats() const { return _stats; }
+
+    //! \brief Number of pages in blocks handed out and not yet given back
+    size_t pages_in_use() const { return _stats.pages_in_use; }
+
+    //! \brief Number of pages in blocks kept for reuse
+    size_t free_pages() const { return _stats.free_pages; }
+
+    //! \brief The calling thread's pool
+    static PagePool &local();
+};
+
+#endif  // SPONGE_LIBSPONGE_PAGE_POOL_HH
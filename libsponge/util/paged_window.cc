@@ -0,0 +1,100 @@
+#include "paged_window.hh"
+
+#include "util.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+using namespace std;
+
+static constexpr size_t PAGE_SIZE = PagePool::PAGE_SIZE;
+
+// A window of `capacity` indices starting anywhere touches at most ceil(capacity / PAGE_SIZE) + 1
+// pages, so with that many slots the pages of the window never share a slot.
+static size_t slots_for(const size_t capacity, const bool power_of_two_storage) {
+    const size_t slots = capacity ? (capacity + PAGE_SIZE - 1) / PAGE_SIZE + 1 : 0;
+    return power_of_two_storage ? round_up_to_power_of_two(slots) : slots;
+}
+
+PagedWindow::PagedWindow(const size_t capacity, const bool power_of_two_storage, Allocator &allocator)
+    : _allocator(&allocator)
+    , _pages(slots_for(capacity, power_of_two_storage), nullptr)
+    , _slot_mask(power_of_two_storage && _pages.size() > 1 ? _pages.size() - 1 : 0) {}
+
+PagedWindow::PagedWindow(PagedWindow &&other) noexcept
+    : _allocator(other._allocator)
+    , _pages(move(other._pages))
+    , _slot_mask(other._slot_mask)
+    , _first_page(other._first_page)
+    , _end_page(other._end_page)
+    , _page_count(other._page_count) {
+    other._pages.clear();
+    other._first_page = other._end_page = 0;
+    other._page_count = 0;
+}
+
+PagedWindow &PagedWindow::operator=(PagedWindow &&other) noexcept {
+    if (this != &other) {
+        release_all();
+        _allocator = other._allocator;
+        _pages = move(other._pages);
+        _slot_mask = other._slot_mask;
+        _first_page = exchange(other._first_page, 0);
+        _end_page = exchange(other._end_page, 0);
+        _page_count = exchange(other._page_count, 0);
+        other._pages.clear();
+    }
+    return *this;
+}
+
+//! \param[in] index is the stream index of the first byte of `data`
+//! \param[in] data is the bytes to copy, which must fit in the window
+void PagedWindow::write(uint64_t index, string_view data) {
+    while (not data.empty()) {
+        const uint64_t page = index / PAGE_SIZE;
+        const size_t offset = index % PAGE_SIZE;
+        const size_t count = min(data.size(), PAGE_SIZE - offset);
+
+        char *&slot = _pages[_slot(page)];
+        if (not slot) {
+            slot = _allocator->allocate_page();
+            _first_page = _page_count ? min(_first_page, page) : page;
+            _end_page = _page_count ? max(_end_page, page + 1) : page + 1;
+            ++_page_count;
+        }
+        memcpy(slot + offset, data.data(), count);
+
+        index += count;
+        data.remove_prefix(count);
+    }
+}
+
+//! \param[in] index is the lowest index whose page is kept
+void PagedWindow::release_below(const uint64_t index) {
+    const uint64_t page = index / PAGE_SIZE;
+    if (_page_count and _first_page < page) {
+        _release_pages(_first_page, min(page, _end_page));
+    }
+}
+
+//! \param[in] first is the page number of the first page to give back
+//! \param[in] end is one past the page number of the last page to give back
+void PagedWindow::_release_pages(const uint64_t first, const uint64_t end) {
+    if (not _page_count) {
+        return;
+    }
+
+    // every page number maps to a slot, so no more than one pass over the ring is ever needed
+    const uint64_t last = first + min(end - first, uint64_t(_pages.size()));
+    for (uint64_t page = first; page < last and _page_count; ++page) {
+        char *&slot = _pages[_slot(page)];
+        if (slot) {
+            _allocator->deallocate_page(slot);
+            slot = nullptr;
+            --_page_count;
+        }
+    }
+    _first_page = _page_count ? end : 0;
+    _end_page = _page_count ? _end_page : 0;
+}
@@ -0,0 +1,81 @@
+#ifndef SPONGE_LIBSPONGE_PAGED_WINDOW_HH
+#define SPONGE_LIBSPONGE_PAGED_WINDOW_HH
+
+#include "page_pool.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+//! \brief Storage for the bytes of a sliding window of `capacity` consecutive stream indices
+//! \details The window is a ring of page slots, addressed by stream index, that starts out
+//! with no pages at all. A page is taken from an Allocator the first time a byte is written
+//! into it, and goes back once the window slides past it (release_below()) or
+//! its bytes are no longer needed (release_all()), so a window that is never written costs
+//! one pointer per page.
+class PagedWindow {
+  private:
+    Allocator *_allocator;       //!< Where pages come from and go back to
+    std::vector<char *> _pages;  //!< The page held in each slot of the ring, or nullptr
+    size_t _slot_mask;           //!< `_pages.size() - 1` if slots are found by masking, otherwise 0
+    uint64_t _first_page{0};     //!< No page below this page number is held
+    uint64_t _end_page{0};       //!< No page at or above this page number is held
+    size_t _page_count{0};       //!< Number of pages held
+
+    //! The slot for the page with page number `page`
+    size_t _slot(const uint64_t page) const {
+        if (_slot_mask) {
+            return page & _slot_mask;
+        }
+        return _pages.empty() ? 0 : page % _pages.size();
+    }
+
+    //! Give back the pages held with page numbers in [`first`, `end`)
+    void _release_pages(const uint64_t first, const uint64_t end);
+
+  public:
+    //! \brief Construct an empty window that can hold `capacity` consecutive indices
+    //! \param capacity is the largest distance between the lowest and highest index written, plus one
+    //! \param power_of_two_storage rounds the number of slots up to a power of two, so that
+    //! page numbers wrap with a mask instead of a division
+    //! \param allocator is where pages are taken from
+    PagedWindow(const size_t capacity,
+                const bool power_of_two_storage = false,
+                Allocator &allocator = HeapAllocator::instance());
+
+    //! \brief Give back every page held
+    ~PagedWindow() { release_all(); }
+
+    PagedWindow(const PagedWindow &) = delete;
+    PagedWindow &operator=(const PagedWindow &) = delete;
+
+    //! \brief Take over the pages of `other`, which is left holding none
+    PagedWindow(PagedWindow &&other) noexcept;
+
+    //! \brief Give back every page held, and take over the pages of `other`, which is left holding none
+    PagedWindow &operator=(PagedWindow &&other) noexcept;
+
+    //! \brief Copy `data` into the window at stream indices [`index`, `index` + `data.size()`),
+    //! taking pages from the allocator as needed
+    void write(const uint64_t index, std::string_view data);
+
+    //! \returns the bytes at stream indices [`index`, `index` + `len`) that lie in the same page as
+    //! `index`, which must have been written
+    std::string_view read(const uint64_t index, const size_t len) const {
+        const size_t offset = index % PagePool::PAGE_SIZE;
+        return {_pages[_slot(index / PagePool::PAGE_SIZE)] + offset, std::min(len, PagePool::PAGE_SIZE - offset)};
+    }
+
+    //! \brief Give back the pages that only hold indices below `index`
+    void release_below(const uint64_t index);
+
+    //! \brief Give back every page held
+    void release_all() { _release_pages(_first_page, _end_page); }
+
+    //! \brief Number of pages held
+    size_t pages() const { return _page_count; }
+};
+
+#endif  // SPONGE_LIBSPONGE_PAGED_WINDOW_HH
@@ -3,8 +3,10 @@
 
 #include "buffer.hh"
 
+#include <arpa/inet.h>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <string>
 #include <utility>
 
@@ -39,6 +41,9 @@ class NetParser {
 
     Buffer buffer() const { return _buffer; }
 
+    //! View of the bytes that haven't been parsed yet (valid until the parser is next changed)
+    std::string_view unparsed() const { return _buffer.str(); }
+
     //! Get the current value stored in BaseParser::_error
     ParseResult get_error() const { return _error; }
 
@@ -60,6 +65,24 @@ class NetParser {
 
     //! Remove n bytes from the buffer
     void remove_prefix(const size_t n);
+
+    //! \name Unchecked loads from memory that is known to be large enough (which may be unaligned)
+    //!@{
+
+    //! Load a 32-bit integer in network byte order
+    static uint32_t load_u32(const char *data) {
+        uint32_t val;
+        memcpy(&val, data, sizeof(val));
+        return ntohl(val);
+    }
+
+    //! Load a 16-bit integer in network byte order
+    static uint16_t load_u16(const char *data) {
+        uint16_t val;
+        memcpy(&val, data, sizeof(val));
+        return ntohs(val);
+    }
+    //!@}
 };
 
 struct NetUnparser {
@@ -74,6 +97,22 @@ struct NetUnparser {
 
     //! Write an 8-bit integer into the data stream in network byte order
     static void u8(std::string &s, const uint8_t val);
+
+    //! \name Unchecked stores into memory that is known to be large enough (which may be unaligned)
+    //!@{
+
+    //! Store a 32-bit integer in network byte order
+    static void store_u32(char *out, const uint32_t val) {
+        const uint32_t net_val = htonl(val);
+        memcpy(out, &net_val, sizeof(net_val));
+    }
+
+    //! Store a 16-bit integer in network byte order
+    static void store_u16(char *out, const uint16_t val) {
+        const uint16_t net_val = htons(val);
+        memcpy(out, &net_val, sizeof(net_val));
+    }
+    //!@}
 };
 
 #endif  // SPONGE_LIBSPONGE_PARSER_HH
@@ -45,6 +45,9 @@ class Socket : public FileDescriptor {
 
     //! Allow local address to be reused sooner via [SO_REUSEADDR](\ref man7::socket)
     void set_reuseaddr();
+
+    //! Allow other sockets to bind to the same address, sharing its traffic, via [SO_REUSEPORT](\ref man7::socket)
+    void set_reuseport();
 };
 
 //! A wrapper around [UDP sockets](\ref man7::udp)
@@ -0,0 +1,175 @@
+#include "timer_wheel.hh"
+
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+//! \param[in] now is the wheel's starting time
+TimerWheel::TimerWheel(const uint64_t now) : _current(now) { _heads.fill(NONE); }
+
+void TimerWheel::_place(const uint32_t index) {
+    Timer &timer = _pool[index];
+
+    // the level is that of the highest group of SLOT_BITS bits in which the deadline and the current time differ
+    const uint64_t difference = timer.deadline ^ _current;
+    const unsigned level = difference ? (63 - __builtin_clzll(difference)) / SLOT_BITS : 0;
+    uint32_t list = OVERFLOW_LIST;
+    if (level < LEVELS) {
+        const auto slot = unsigned(timer.deadline >> (level * SLOT_BITS)) % SLOTS;
+        list = level * SLOTS + slot;
+        _occupied[level] |= uint64_t(1) << slot;
+    }
+
+    timer.list = list;
+    timer.prev = NONE;
+    timer.next = _heads[list];
+    if (timer.next != NONE) {
+        _pool[timer.next].prev = index;
+    }
+    _heads[list] = index;
+}
+
+void TimerWheel::_unlink(const uint32_t index) {
+    Timer &timer = _pool[index];
+    if (timer.prev != NONE) {
+        _pool[timer.prev].next = timer.next;
+    } else {
+        _heads[timer.list] = timer.next;
+        if (timer.next == NONE and timer.list < OVERFLOW_LIST) {
+            _occupied[timer.list / SLOTS] &= ~(uint64_t(1) << (timer.list % SLOTS));
+        }
+    }
+    if (timer.next != NONE) {
+        _pool[timer.next].prev = timer.prev;
+    }
+}
+
+void TimerWheel::_release(const uint32_t index) {
+    Timer &timer = _pool[index];
+    timer.callback = nullptr;
+    timer.list = NONE;
+    ++timer.generation;
+    timer.next = _free;
+    _free = index;
+    --_size;
+}
+
+void TimerWheel::_cascade(const uint32_t list) {
+    // detach the whole list first, since timers still far off go back to the overflow list
+    uint32_t index = _heads[list];
+    _heads[list] = NONE;
+    if (list != OVERFLOW_LIST) {
+        _occupied[list / SLOTS] &= ~(uint64_t(1) << (list % SLOTS));
+    }
+    while (index != NONE) {
+        const uint32_t next = _pool[index].next;
+        _place(index);
+        index = next;
+    }
+}
+
+void TimerWheel::_move_to(const uint64_t now) {
+    _current = now;
+    if (_current % SLOTS != 0) {
+        return;
+    }
+    // the highest level first, so that timers can come down more than one level at once
+    if (_current % (uint64_t(1) << (LEVELS * SLOT_BITS)) == 0) {
+        _cascade(OVERFLOW_LIST);
+    }
+    for (unsigned level = LEVELS - 1; level > 0; --level) {
+        if (_current % (uint64_t(1) << (level * SLOT_BITS)) == 0) {
+            _cascade(level * SLOTS + unsigned(_current >> (level * SLOT_BITS)) % SLOTS);
+        }
+    }
+}
+
+//! \param[in] deadline is the time at which the timer expires
+//! \param[in] callback is called when the timer expires
+TimerWheel::Handle TimerWheel::add(const uint64_t deadline, const CallbackT &callback) {
+    uint32_t index = _free;
+    if (index != NONE) {
+        _free = _pool[index].next;
+    } else {
+        index = uint32_t(_pool.size());
+        _pool.emplace_back();
+    }
+
+    Timer &timer = _pool[index];
+    timer.deadline = max(deadline, _current);
+    timer.callback = callback;
+    _place(index);
+    ++_size;
+    return {index, timer.generation};
+}
+
+//! \param[in] handle is what add() returned for the timer
+bool TimerWheel::cancel(const Handle handle) {
+    if (handle.index >= _pool.size()) {
+        return false;
+    }
+    const Timer &timer = _pool[handle.index];
+    if (timer.generation != handle.generation or timer.list == NONE) {
+        return false;
+    }
+    _unlink(handle.index);
+    _release(handle.index);
+    return true;
+}
+
+//! \param[in] now is the time to advance to
+size_t TimerWheel::advance(const uint64_t now) {
+    size_t expired = 0;
+    while (_current <= now) {
+        // skip straight to the earliest slot that holds timers, unless it lies beyond `now`
+        const auto next = next_deadline();
+        if (not next.has_value() or *next > now) {
+            _move_to(now + 1);
+            break;
+        }
+        if (*next > _current) {
+            _move_to(*next);
+            continue;  // the move may have brought timers down to level 0
+        }
+
+        // run the slot of level 0 for the current millisecond; its timers are moved to a list of
+        // their own first, since the callbacks may add and cancel timers and time moves on meanwhile
+        const uint32_t slot = unsigned(_current) % SLOTS;
+        uint32_t index = _heads[slot];
+        _heads[slot] = NONE;
+        _occupied[0] &= ~(uint64_t(1) << slot);
+        _heads[RUNNING] = index;
+        for (; index != NONE; index = _pool[index].next) {
+            _pool[index].list = RUNNING;
+        }
+        _move_to(_current + 1);
+
+        while (_heads[RUNNING] != NONE) {
+            index = _heads[RUNNING];
+            _unlink(index);
+            CallbackT callback = move(_pool[index].callback);
+            _release(index);
+            callback();
+            ++expired;
+        }
+    }
+    return expired;
+}
+
+std::optional<uint64_t> TimerWheel::next_deadline() const {
+    if (_size == 0) {
+        return {};
+    }
+
+    // the occupied slots of each level lie at or after the current time's, within the current turn of the level
+    for (unsigned level = 0; level < LEVELS; ++level) {
+        if (_occupied[level]) {
+            const unsigned shift = level * SLOT_BITS;
+            const uint64_t turn = (_current >> (shift + SLOT_BITS)) << (shift + SLOT_BITS);
+            const uint64_t slot = __builtin_ctzll(_occupied[level]);
+            return max(turn + (slot << shift), _current);
+        }
+    }
+    return ((_current >> (LEVELS * SLOT_BITS)) + 1) << (LEVELS * SLOT_BITS);
+}
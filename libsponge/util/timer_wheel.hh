@@ -0,0 +1,101 @@
+#ifndef SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+#define SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+//! \brief A hierarchical timing wheel of one-shot timers with millisecond deadlines
+//! \details The wheel has LEVELS levels of SLOTS slots each. Level 0 has a slot for each of the
+//! next SLOTS milliseconds, and each slot of level `L` covers SLOTS times as long as a slot of level
+//! `L - 1`. A timer is put in the lowest level whose slots tell its deadline apart from the current
+//! time, and timers beyond the top level wait in an overflow list. When time reaches a slot of a
+//! higher level, its timers are moved down a level or more (each timer at most LEVELS times), and
+//! the slots of level 0 are run as their millisecond comes.
+//!
+//! Every slot is an intrusive doubly-linked list of timers kept in one pool, and every level
+//! has a bitmap of its non-empty slots, so add() and cancel() are O(1), and advance() and
+//! next_deadline() skip empty slots a word at a time.
+class TimerWheel {
+  public:
+    using CallbackT = std::function<void(void)>;  //!< Called when a timer expires
+
+    //! \brief Identifies a timer; stays safe to cancel after the timer has expired or been canceled
+    struct Handle {
+        uint32_t index{UINT32_MAX};  //!< The timer's position in the pool
+        uint32_t generation{0};      //!< The pool entry's generation when the timer was added
+    };
+
+    static constexpr unsigned SLOT_BITS = 6;                   //!< log2 of SLOTS
+    static constexpr unsigned SLOTS = 1 << SLOT_BITS;          //!< Slots per level
+    static constexpr unsigned LEVELS = 4;                      //!< Levels of the wheel
+    static constexpr unsigned OVERFLOW_LIST = LEVELS * SLOTS;  //!< The list of timers beyond the top level
+
+  private:
+    static constexpr uint32_t NONE = UINT32_MAX;            //!< The end of a list
+    static constexpr uint32_t RUNNING = OVERFLOW_LIST + 1;  //!< The list of timers being run
+
+    //! \brief A timer, or a free entry of the pool
+    struct Timer {
+        uint64_t deadline{0};    //!< When the timer expires
+        CallbackT callback{};    //!< What to call then
+        uint32_t prev{NONE};     //!< The previous timer in the same list
+        uint32_t next{NONE};     //!< The next timer in the same list (or the next free entry)
+        uint32_t list{NONE};     //!< The slot (or OVERFLOW_LIST) that holds the timer, or NONE if free
+        uint32_t generation{0};  //!< Bumped every time the entry is freed
+    };
+
+    std::vector<Timer> _pool{};                        //!< Every timer, pending or free
+    uint32_t _free{NONE};                              //!< The first free entry of the pool
+    std::array<uint32_t, RUNNING + 1> _heads{};  //!< The first timer of each list
+    std::array<uint64_t, LEVELS> _occupied{};    //!< For each level, a bit for each slot that holds timers
+    uint64_t _current;                           //!< The next millisecond to run
+    size_t _size{0};                             //!< Number of pending timers
+
+    //! Put timer `index` in the list for its deadline
+    void _place(const uint32_t index);
+
+    //! Take timer `index` out of its list
+    void _unlink(const uint32_t index);
+
+    //! Return entry `index` to the free list
+    void _release(const uint32_t index);
+
+    //! Move the timers of list `list` to the lists for their deadlines
+    void _cascade(const uint32_t list);
+
+    //! Make `now` the next millisecond to run, bringing down the timers of the slots that start then
+    void _move_to(const uint64_t now);
+
+  public:
+    //! \brief Construct an empty wheel whose time starts at `now`
+    explicit TimerWheel(const uint64_t now = 0);
+
+    //! \brief Add a timer that calls `callback` once, at the first advance() to reach `deadline`
+    //! \details A deadline before the time the wheel last advanced to runs at the following millisecond.
+    Handle add(const uint64_t deadline, const CallbackT &callback);
+
+    //! \brief Cancel a pending timer
+    //! \returns `true` if the timer was pending, `false` if it has already expired or been canceled
+    bool cancel(const Handle handle);
+
+    //! \brief Run every timer whose deadline is at or before `now`, in order of deadline
+    //! \details Timers with the same deadline run in no particular order. Callbacks may add and cancel timers.
+    //! \returns the number of timers run
+    size_t advance(const uint64_t now);
+
+    //! \brief A time at or before the earliest deadline, and after the time last advanced to,
+    //! or nothing if no timer is pending
+    std::optional<uint64_t> next_deadline() const;
+
+    //! \brief Number of pending timers
+    size_t size() const { return _size; }
+
+    //! \brief Whether no timer is pending
+    bool empty() const { return _size == 0; }
+};
+
+#endif  // SPONGE_LIBSPONGE_TIMER_WHEEL_HH
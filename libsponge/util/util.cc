@@ -1,13 +1,21 @@
 #include "util.hh"
 
+#include <arpa/inet.h>
 #include <array>
+#include <atomic>
 #include <cctype>
 #include <chrono>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <sys/socket.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SPONGE_CHECKSUM_X86 1
+#endif
+
 using namespace std;
 
 //! \returns the number of milliseconds since the program started
@@ -18,6 +26,9 @@ uint64_t timestamp_ms() {
     return std::chrono::duration_cast<std::chrono::milliseconds>(now - program_start).count();
 }
 
+//! Counts the calls to SystemCall made by each thread
+static thread_local uint64_t system_calls = 0;
+
 //! \param[in] attempt is the name of the syscall to try (for error reporting)
 //! \param[in] return_value is the return value of the syscall
 //! \param[in] errno_mask is any errno value that is acceptable, e.g., `EAGAIN` when reading a non-blocking fd
@@ -40,6 +51,7 @@ uint64_t timestamp_ms() {
 //! }
 //! ~~~
 int SystemCall(const char *attempt, const int return_value, const int errno_mask) {
+    ++system_calls;
     if (return_value >= 0 || errno == errno_mask) {
         return return_value;
     }
@@ -55,6 +67,9 @@ int SystemCall(const string &attempt, const int return_value, const int errno_ma
     return SystemCall(attempt.c_str(), return_value, errno_mask);
 }
 
+//! \details Benchmarks use this to compare how many syscalls different strategies make
+uint64_t system_call_count() { return system_calls; }
+
 //! \details A properly seeded mt19937 generator takes a lot of entropy!
 //!
 //! This code borrows from the following:
@@ -84,21 +99,192 @@ mt19937 get_random_generator() {
 //!
 //! For more information, see the [Wikipedia page](https://en.wikipedia.org/wiki/IPv4_header_checksum)
 //! on the Internet checksum, and consult the [IP](\ref rfc::rfc791) and [TCP](\ref rfc::rfc793) RFCs.
-InternetChecksum::InternetChecksum(const uint32_t initial_sum) : _sum(initial_sum) {}
+//!
+//! Each chunk passed to add() is summed as 16-bit words in host byte order, which gives the
+//! byte-swapped ones' complement sum on a little-endian host; the folded result is swapped
+//! back afterwards (see [RFC 1071](\ref rfc::rfc1071), section 2(B)). The bulk of a chunk is
+//! summed eight bytes at a time into a 64-bit accumulator with end-around carry, or with
+//! SSE2/AVX2 when the CPU supports them.
+InternetChecksum::InternetChecksum(const uint64_t initial_sum) : _sum(initial_sum) {}
 
-void InternetChecksum::add(std::string_view data) {
-    for (size_t i = 0; i < data.size(); i++) {
-        uint16_t val = uint8_t(data[i]);
-        if (not _parity) {
-            val <<= 8;
+namespace {
+
+//! Fold a ones' complement sum down to 16 bits (a non-zero sum never folds to zero)
+uint16_t fold_sum(uint64_t sum) {
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return uint16_t(sum);
+}
+
+//! Ones' complement sum of the host-order 16-bit words in `data`, where `len` is even
+uint64_t sum_words_portable(const char *data, const size_t len) {
+    uint64_t sum = 0;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        sum += word;
+        sum += sum < word;  // end-around carry
+    }
+
+    uint64_t tail = fold_sum(sum);
+    for (; i < len; i += 2) {
+        uint16_t word;
+        memcpy(&word, data + i, sizeof(word));
+        tail += word;
+    }
+    return tail;
+}
+
+#ifdef SPONGE_CHECKSUM_X86
+// The vector kernels split each 32-bit lane into its two 16-bit words and add both to a 32-bit
+// lane of the accumulator. That adds less than 2^17 to a lane per step, so the lanes are moved
+// into a 64-bit sum every 2^15 steps, before they can overflow.
+constexpr size_t VECTOR_STEPS_PER_FLUSH = size_t(1) << 15;
+
+__attribute__((target("sse2"))) uint64_t sum_words_sse2(const char *data, const size_t len) {
+    const __m128i low_words = _mm_set1_epi32(0xffff);
+    uint64_t sum = 0;
+    size_t i = 0;
+    while (len - i >= 16) {
+        const size_t steps = min((len - i) / 16, VECTOR_STEPS_PER_FLUSH);
+        __m128i lanes = _mm_setzero_si128();
+        for (size_t step = 0; step < steps; ++step, i += 16) {
+            const __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            lanes = _mm_add_epi32(lanes, _mm_and_si128(words, low_words));
+            lanes = _mm_add_epi32(lanes, _mm_srli_epi32(words, 16));
+        }
+
+        alignas(16) array<uint32_t, 4> lane_sums{};
+        _mm_store_si128(reinterpret_cast<__m128i *>(lane_sums.data()), lanes);
+        for (const uint32_t lane_sum : lane_sums) {
+            sum += lane_sum;
+        }
+    }
+    return sum + sum_words_portable(data + i, len - i);
+}
+
+__attribute__((target("avx2"))) uint64_t sum_words_avx2(const char *data, const size_t len) {
+    const __m256i low_words = _mm256_set1_epi32(0xffff);
+    uint64_t sum = 0;
+    size_t i = 0;
+    while (len - i >= 32) {
+        const size_t steps = min((len - i) / 32, VECTOR_STEPS_PER_FLUSH);
+        __m256i lanes = _mm256_setzero_si256();
+        for (size_t step = 0; step < steps; ++step, i += 32) {
+            const __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+            lanes = _mm256_add_epi32(lanes, _mm256_and_si256(words, low_words));
+            lanes = _mm256_add_epi32(lanes, _mm256_srli_epi32(words, 16));
+        }
+
+        alignas(32) array<uint32_t, 8> lane_sums{};
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lane_sums.data()), lanes);
+        for (const uint32_t lane_sum : lane_sums) {
+            sum += lane_sum;
+        }
+    }
+    return sum + sum_words_portable(data + i, len - i);
+}
+#endif  // SPONGE_CHECKSUM_X86
+
+bool kernel_supported(const InternetChecksum::Kernel kernel) {
+    switch (kernel) {
+        case InternetChecksum::Kernel::Portable:
+            return true;
+#ifdef SPONGE_CHECKSUM_X86
+        case InternetChecksum::Kernel::SSE2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2");
+        case InternetChecksum::Kernel::AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+//! The kernel in use, chosen (with cpuid) the first time it is needed; any thread may select another
+atomic<InternetChecksum::Kernel> &active_kernel() {
+    static atomic<InternetChecksum::Kernel> kernel{[] {
+        for (const auto candidate : {InternetChecksum::Kernel::AVX2, InternetChecksum::Kernel::SSE2}) {
+            if (kernel_supported(candidate)) {
+                return candidate;
+            }
         }
-        _sum += val;
-        _parity = !_parity;
+        return InternetChecksum::Kernel::Portable;
+    }()};
+    return kernel;
+}
+
+//! Ones' complement sum of the host-order 16-bit words in `data`, where `len` is even
+uint64_t sum_words(const char *data, const size_t len) {
+#ifdef SPONGE_CHECKSUM_X86
+    // short chunks (e.g. headers) don't fill enough vectors to be worth it
+    if (len >= 64) {
+        switch (active_kernel().load(memory_order_relaxed)) {
+            case InternetChecksum::Kernel::AVX2:
+                return sum_words_avx2(data, len);
+            case InternetChecksum::Kernel::SSE2:
+                return sum_words_sse2(data, len);
+            default:
+                break;
+        }
+    }
+#endif
+    return sum_words_portable(data, len);
+}
+
+}  // namespace
+
+bool InternetChecksum::select_kernel(const Kernel kernel) {
+    if (not kernel_supported(kernel)) {
+        return false;
+    }
+    active_kernel().store(kernel, memory_order_relaxed);
+    return true;
+}
+
+InternetChecksum::Kernel InternetChecksum::kernel() { return active_kernel().load(memory_order_relaxed); }
+
+//! \details This is equation 3 of [RFC 1624](\ref rfc::rfc1624): HC' = ~(~HC + ~m + m'). The word
+//! must start at an even offset into the checksummed data.
+//! \param[in] checksum is the checksum of the data before the change (e.g., a header's checksum field)
+//! \param[in] old_word is the word's old value
+//! \param[in] new_word is the word's new value
+//! \returns the checksum of the changed data
+uint16_t InternetChecksum::update(const uint16_t checksum, const uint16_t old_word, const uint16_t new_word) {
+    return ~fold_sum(uint64_t(uint16_t(~checksum)) + uint16_t(~old_word) + new_word);
+}
+
+//! \param[in] data is the next chunk of the summed bytes, which may have any length
+void InternetChecksum::add(std::string_view data) {
+    const char *bytes = data.data();
+    size_t len = data.size();
+
+    // an odd-length chunk left a 16-bit word half done, and this chunk's first byte is its low half
+    if (_parity and len) {
+        _sum += uint8_t(*bytes);
+        _parity = false;
+        ++bytes;
+        --len;
+    }
+
+    const size_t even_len = len & ~size_t(1);
+    if (even_len) {
+        _sum += ntohs(fold_sum(sum_words(bytes, even_len)));
+    }
+
+    // an odd byte left over is the high half of a word that the next chunk finishes
+    if (len & 1) {
+        _sum += uint16_t(uint8_t(bytes[even_len]) << 8);
+        _parity = true;
     }
 }
 
 uint16_t InternetChecksum::value() const {
-    uint32_t ret = _sum;
+    uint64_t ret = _sum;
 
     while (ret > 0xffff) {
         ret = (ret >> 16) + (ret & 0xffff);
@@ -8,7 +8,9 @@
 #include <iterator>
 #include <ostream>
 #include <random>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <system_error>
 #include <vector>
 
@@ -45,22 +47,53 @@ int SystemCall(const char *attempt, const int return_value, const int errno_mask
 //! Version of SystemCall that takes a C++ std::string
 int SystemCall(const std::string &attempt, const int return_value, const int errno_mask = 0);
 
+//! Number of syscalls this thread has checked with SystemCall
+uint64_t system_call_count();
+
 //! Seed a fast random generator
 std::mt19937 get_random_generator();
 
+//! Round `n` up to the nearest power of two (zero stays zero)
+//! \throws std::overflow_error if the power of two would not fit in a size_t
+inline size_t round_up_to_power_of_two(size_t n) {
+    if (n > SIZE_MAX / 2 + 1) {
+        throw std::overflow_error("round_up_to_power_of_two: result does not fit in a size_t");
+    }
+    size_t power = 1;
+    while (n && power < n) {
+        power <<= 1;
+    }
+    return n ? power : 0;
+}
+
 //! Get the time in milliseconds since the program began.
 uint64_t timestamp_ms();
 
 //! The internet checksum algorithm
 class InternetChecksum {
+  public:
+    //! The routines that can sum the bulk of the data passed to add()
+    enum class Kernel { Portable, SSE2, AVX2 };
+
   private:
-    uint32_t _sum;
+    uint64_t _sum;
     bool _parity{};
 
   public:
-    InternetChecksum(const uint32_t initial_sum = 0);
+    InternetChecksum(const uint64_t initial_sum = 0);
     void add(std::string_view data);
     uint16_t value() const;
+
+    //! \brief Update `checksum` after one 16-bit word of the checksummed data changed
+    //! from `old_word` to `new_word` (all in host byte order), without summing the data again
+    static uint16_t update(const uint16_t checksum, const uint16_t old_word, const uint16_t new_word);
+
+    //! \brief Sum with `kernel` from now on, if this CPU supports it
+    //! \returns whether `kernel` is supported (if not, the current kernel is kept)
+    static bool select_kernel(const Kernel kernel);
+
+    //! The kernel in use, initially the fastest one this CPU supports
+    static Kernel kernel();
 };
 
 //! Hexdump the contents of a packet (or any other sequence of bytes)
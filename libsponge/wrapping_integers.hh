@@ -1,20 +1,23 @@
 #ifndef SPONGE_LIBSPONGE_WRAPPING_INTEGERS_HH
 #define SPONGE_LIBSPONGE_WRAPPING_INTEGERS_HH
 
+#include <cstddef>
 #include <cstdint>
 #include <ostream>
 
 //! \brief A 32-bit integer, expressed relative to an arbitrary initial sequence number (ISN)
 //! \note This is used to express TCP sequence numbers (seqno) and acknowledgment numbers (ackno)
+//! \note The class, wrap(), unwrap() and the helper operators are all constexpr, so that they
+//! inline into the per-segment paths and fold when their operands are known.
 class WrappingInt32 {
   private:
     uint32_t _raw_value;  //!< The raw 32-bit stored integer
 
   public:
     //! Construct from a raw 32-bit unsigned integer
-    explicit WrappingInt32(uint32_t raw_value) : _raw_value(raw_value) {}
+    explicit constexpr WrappingInt32(uint32_t raw_value) : _raw_value(raw_value) {}
 
-    uint32_t raw_value() const { return _raw_value; }  //!< Access raw stored value
+    constexpr uint32_t raw_value() const { return _raw_value; }  //!< Access raw stored value
 };
 
 /**
@@ -24,7 +27,10 @@ class WrappingInt32 {
  * @param isn The ISN
  * @return WrappingInt32
  */
-WrappingInt32 wrap(uint64_t asn, WrappingInt32 isn);
+constexpr WrappingInt32 wrap(uint64_t asn, WrappingInt32 isn) {
+    // the ASN is the distance between the ISN and its 64-bit RSN, which wraps by keeping only its lower 32 bits
+    return WrappingInt32{uint32_t(asn + uint64_t(isn.raw_value()))};
+}
 
 /**
  * @brief Transform a WrappingInt32 SN into a 64-bit ASN.
@@ -37,7 +43,46 @@ WrappingInt32 wrap(uint64_t asn, WrappingInt32 isn);
  * @param checkpoint A 64-bit number close to ASN
  * @return uint64_t
  */
-uint64_t unwrap(WrappingInt32 sn, WrappingInt32 isn, uint64_t checkpoint);
+constexpr uint64_t unwrap(WrappingInt32 sn, WrappingInt32 isn, uint64_t checkpoint) {
+    // lower 32 bits of ASN is obtained by subtracting ISN from SN
+    const uint32_t offset = sn.raw_value() - isn.raw_value();
+    const uint32_t lower = uint32_t(checkpoint);
+    const uint32_t upper = uint32_t(checkpoint >> 32);
+
+    /*
+     * The signed 32-bit difference between the offset and the lower 32 bits of
+     * the checkpoint is the shortest way from the checkpoint to an ASN with the
+     * right lower 32 bits, so that ASN is the closest one. Its upper 32 bits are
+     * one less than the checkpoint's if going back that far borrows, and one
+     * more if going forward carries. The upper 32 bits of the checkpoint are
+     * kept on a tie (the ASN is 2^31 away either way), and where they would go
+     * below 0 or above 2^32 - 1.
+     *
+     * There are no branches, and everything is 32 bits wide until the end, so
+     * that unwrap_many() vectorizes even without 64-bit vector comparisons.
+     */
+    const int32_t delta = int32_t(offset - lower);
+    const uint32_t borrow = (delta < 0) & (delta != INT32_MIN) & (offset > lower) & (upper != 0);
+    const uint32_t carry = (delta > 0) & (offset < lower) & (upper != UINT32_MAX);
+    return (uint64_t(upper + carry - borrow) << 32) | offset;
+}
+
+/**
+ * @brief Transform `count` WrappingInt32 SNs into 64-bit ASNs, each exactly as
+ * unwrap() would with the same checkpoint.
+ *
+ * @note One checkpoint serves the whole batch, so that the SNs are unwrapped
+ * independently (and with SIMD instructions where available), e.g. for a burst
+ * of segments or a capture being replayed. Each ASN is still the closest one
+ * to the checkpoint, so the batch should span well under 2^31 SNs.
+ *
+ * @param sns The SNs
+ * @param asns Where the `count` ASNs are stored
+ * @param count The number of SNs
+ * @param isn The ISN
+ * @param checkpoint A 64-bit number close to every ASN
+ */
+void unwrap_many(const WrappingInt32 *sns, uint64_t *asns, const size_t count, WrappingInt32 isn, uint64_t checkpoint);
 
 //! \name Helper functions
 //!@{
@@ -48,22 +93,22 @@ uint64_t unwrap(WrappingInt32 sn, WrappingInt32 isn, uint64_t checkpoint);
 //! \returns the number of increments needed to get from `b` to `a`,
 //! negative if the number of decrements needed is less than or equal to
 //! the number of increments
-inline int32_t operator-(WrappingInt32 a, WrappingInt32 b) { return a.raw_value() - b.raw_value(); }
+constexpr int32_t operator-(WrappingInt32 a, WrappingInt32 b) { return a.raw_value() - b.raw_value(); }
 
 //! \brief Whether the two integers are equal.
-inline bool operator==(WrappingInt32 a, WrappingInt32 b) { return a.raw_value() == b.raw_value(); }
+constexpr bool operator==(WrappingInt32 a, WrappingInt32 b) { return a.raw_value() == b.raw_value(); }
 
 //! \brief Whether the two integers are not equal.
-inline bool operator!=(WrappingInt32 a, WrappingInt32 b) { return !(a == b); }
+constexpr bool operator!=(WrappingInt32 a, WrappingInt32 b) { return !(a == b); }
 
 //! \brief Serializes the wrapping integer, `a`.
 inline std::ostream &operator<<(std::ostream &os, WrappingInt32 a) { return os << a.raw_value(); }
 
 //! \brief The point `b` steps past `a`.
-inline WrappingInt32 operator+(WrappingInt32 a, uint32_t b) { return WrappingInt32{a.raw_value() + b}; }
+constexpr WrappingInt32 operator+(WrappingInt32 a, uint32_t b) { return WrappingInt32{a.raw_value() + b}; }
 
 //! \brief The point `b` steps before `a`.
-inline WrappingInt32 operator-(WrappingInt32 a, uint32_t b) { return a + -b; }
+constexpr WrappingInt32 operator-(WrappingInt32 a, uint32_t b) { return a + -b; }
 //!@}
 
 #endif  // SPONGE_LIBSPONGE_WRAPPING_INTEGERS_HH
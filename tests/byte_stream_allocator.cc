@@ -0,0 +1,121 @@
+#include "byte_stream.hh"
+#include "page_pool.hh"
+#include "stream_reassembler.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+// Checks that every block is given back, with the size it was allocated with
+class CountingAllocator : public Allocator {
+    map<char *, size_t> _blocks{};
+
+  public:
+    size_t allocations{0};
+
+    char *allocate(const size_t size) override {
+        ++allocations;
+        char *block = new char[size];
+        _blocks.emplace(block, size);
+        return block;
+    }
+
+    void deallocate(char *block, const size_t size) override {
+        const auto it = _blocks.find(block);
+        if (it == _blocks.end() or it->second != size) {
+            throw runtime_error("a block was given back with the wrong size, or twice");
+        }
+        _blocks.erase(it);
+        delete[] block;
+    }
+
+    size_t outstanding() const { return _blocks.size(); }
+};
+
+static void expect(const bool condition, const string &what) {
+    if (not condition) {
+        throw runtime_error(what);
+    }
+}
+
+int main() {
+    try {
+        {
+            CountingAllocator allocator;
+            {
+                ByteStream stream{1000, false, allocator};
+                expect(allocator.allocations == 0, "a new ByteStream allocated its ring");
+                expect(stream.write(Buffer{string(100, 'b')}) == 100, "write(Buffer) failed");
+                expect(allocator.allocations == 0, "a Buffer held by reference allocated the ring");
+                expect(stream.write(string(100, 'x')) == 100, "write() failed");
+                expect(allocator.allocations == 1 and allocator.outstanding() == 1,
+                       "write() did not allocate the ring");
+
+                ByteStream moved{move(stream)};
+                expect(allocator.allocations == 1, "moving a ByteStream allocated a ring");
+                expect(moved.read(200) == string(100, 'b') + string(100, 'x'), "moved ByteStream lost bytes");
+            }
+            expect(allocator.outstanding() == 0, "ByteStream did not give its ring back");
+
+            for (const auto backend : {StreamReassembler::Backend::Intervals, StreamReassembler::Backend::Bitmap}) {
+                {
+                    StreamReassembler reassembler{1 << 16, true, backend, allocator};
+                    reassembler.push_substring(string(5000, 'y'), 5000, false);
+                    reassembler.push_substring(string(5000, 'x'), 0, false);
+                    expect(reassembler.stream_out().read(10000) == string(5000, 'x') + string(5000, 'y'),
+                           "reassembler lost bytes");
+                    reassembler.push_substring(string(5000, 'z'), 20000, false);
+                }
+                expect(allocator.outstanding() == 0, "StreamReassembler did not give its storage back");
+            }
+        }
+
+        {
+            PagePool pool;
+            char *one = pool.allocate(100);
+            char *two = pool.allocate(PagePool::PAGE_SIZE + 1);
+            char *four = pool.allocate(3 * PagePool::PAGE_SIZE);
+            expect(pool.pages_in_use() == 7 and pool.stats().high_water_mark == 7, "blocks were not rounded up");
+            expect(pool.stats().heap_pages == 7 and pool.free_pages() == 0, "an empty pool reused a block");
+
+            pool.deallocate(two, PagePool::PAGE_SIZE + 1);
+            pool.deallocate(four, 3 * PagePool::PAGE_SIZE);
+            expect(pool.pages_in_use() == 1 and pool.free_pages() == 6, "given-back blocks were not kept");
+            expect(pool.stats().high_water_mark == 7, "the high-water mark went down");
+
+            // a block is reused for any size in its class
+            expect(pool.allocate(4 * PagePool::PAGE_SIZE) == four, "a free block was not reused");
+            expect(pool.stats().heap_pages == 7 and pool.free_pages() == 2, "reuse went to the heap");
+            pool.deallocate(four, 4 * PagePool::PAGE_SIZE);
+            pool.deallocate(one, 100);
+            expect(pool.pages_in_use() == 0 and pool.free_pages() == 7, "pages were lost");
+
+            // blocks larger than MAX_BLOCK_SIZE are not kept
+            char *huge = pool.allocate(PagePool::MAX_BLOCK_SIZE + 1);
+            expect(pool.pages_in_use() == PagePool::MAX_BLOCK_SIZE / PagePool::PAGE_SIZE + 1, "huge block miscounted");
+            pool.deallocate(huge, PagePool::MAX_BLOCK_SIZE + 1);
+            expect(pool.pages_in_use() == 0 and pool.free_pages() == 7, "a huge block was kept");
+        }
+
+        {
+            // no more than `max_free_pages` pages are kept
+            PagePool pool{2};
+            char *page = pool.allocate(PagePool::PAGE_SIZE);
+            char *four = pool.allocate(4 * PagePool::PAGE_SIZE);
+            pool.deallocate(four, 4 * PagePool::PAGE_SIZE);
+            pool.deallocate(page, PagePool::PAGE_SIZE);
+            expect(pool.free_pages() == 1, "the pool kept more pages than it was allowed");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,88 @@
+#include "byte_stream.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// The per-byte ring buffer that ByteStream used before switching to bulk copies,
+// kept here as the baseline for the comparison.
+class PerByteRing {
+    vector<char> buffer;
+    size_t capacity;
+    size_t size = 0;
+    size_t start = 0;
+
+    size_t wrap_index(const size_t index) const { return capacity == 0 ? 0 : index % capacity; }
+
+  public:
+    PerByteRing(const size_t bytes) : buffer(bytes), capacity(bytes) {}
+
+    size_t write(const string &data) {
+        size_t written = 0;
+        for (auto source = data.begin(); source != data.end() && capacity - size; ++source, ++size, ++written) {
+            buffer[wrap_index(start + size)] = *source;
+        }
+        return written;
+    }
+
+    string read(const size_t len) {
+        string data;
+        for (size_t peeked = 0; peeked < size && peeked < len; ++peeked) {
+            data.append(1, buffer[wrap_index(start + peeked)]);
+        }
+        const size_t popped = min(len, size);
+        size -= popped;
+        start = wrap_index(start + popped);
+        return data;
+    }
+};
+
+template <typename Stream>
+double gigabytes_per_second(const size_t capacity, const size_t chunk, const size_t total) {
+    Stream stream{capacity};
+    const string data(chunk, 'x');
+    size_t moved = 0;
+
+    const auto begin = chrono::steady_clock::now();
+    while (moved < total) {
+        stream.write(data);
+        const string out = stream.read(chunk);
+        if (out.size() != chunk or out.back() != 'x') {
+            throw runtime_error("byte_stream_benchmark: data mismatch");
+        }
+        moved += out.size();
+    }
+    const auto end = chrono::steady_clock::now();
+
+    const double seconds = chrono::duration<double>(end - begin).count();
+    return double(moved) / seconds / 1e9;
+}
+
+int main() {
+    try {
+        constexpr size_t CAPACITY = 64 * 1024 + 7;  // odd size so writes keep wrapping
+        constexpr size_t TOTAL = 256 * 1024 * 1024;
+
+        cout << fixed << setprecision(3);
+        cout << setw(8) << "chunk" << setw(14) << "per-byte GB/s" << setw(14) << "bulk GB/s" << setw(10) << "speedup"
+             << "\n";
+        for (const size_t chunk : {64, 1460, 4096, 16384}) {
+            const double naive = gigabytes_per_second<PerByteRing>(CAPACITY, chunk, TOTAL / 8);
+            const double bulk = gigabytes_per_second<ByteStream>(CAPACITY, chunk, TOTAL);
+            cout << setw(8) << chunk << setw(14) << naive << setw(14) << bulk << setw(9) << bulk / naive << "x\n";
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -81,6 +81,7 @@ int main() {
                 test.execute(Write{"abc"}.with_bytes_written(1));
                 test.execute(RemainingCapacity{0});
                 test.execute(Peek{"bca"});
+                test.execute(PeekViews{"bca"});
                 test.execute(Pop{1});
 
                 test.execute(RemainingCapacity{1});
@@ -88,6 +89,7 @@ int main() {
                 test.execute(Write{"bca"}.with_bytes_written(1));
                 test.execute(RemainingCapacity{0});
                 test.execute(Peek{"cab"});
+                test.execute(PeekViews{"cab"});
                 test.execute(Pop{1});
 
                 test.execute(RemainingCapacity{1});
@@ -95,11 +97,13 @@ int main() {
                 test.execute(Write{"cab"}.with_bytes_written(1));
                 test.execute(RemainingCapacity{0});
                 test.execute(Peek{"abc"});
+                test.execute(PeekViews{"abc"});
                 test.execute(Pop{1});
             }
 
             test.execute(EndInput{});
             test.execute(Peek{"bc"});
+            test.execute(PeekViews{"bc"});
             test.execute(Pop{2});
             test.execute(Eof{true});
         }
@@ -0,0 +1,78 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            ByteStreamTestHarness test{"write-buffer-read-buffers", 15};
+
+            test.execute(WriteBuffer{"cat"}.with_bytes_written(3));
+            test.execute(WriteBuffer{"dog"}.with_bytes_written(3));
+
+            test.execute(BufferSize{6});
+            test.execute(RemainingCapacity{9});
+            test.execute(BytesWritten{6});
+            test.execute(Peek{"catdog"});
+            test.execute(PeekViews{"ca"});
+
+            test.execute(WriteBuffer{"pig"}.with_bytes_written(3));
+            test.execute(PeekViews{"catdogp"});
+
+            test.execute(ReadBuffers{"catd"});
+            test.execute(BytesRead{4});
+            test.execute(BufferSize{5});
+            test.execute(Peek{"ogpig"});
+        }
+
+        {
+            ByteStreamTestHarness test{"buffers-then-copies", 8};
+
+            test.execute(WriteBuffer{"abc"}.with_bytes_written(3));
+            test.execute(Write{"def"}.with_bytes_written(3));
+            test.execute(WriteBuffer{"ghi"}.with_bytes_written(2));
+
+            test.execute(RemainingCapacity{0});
+            test.execute(Peek{"abcdefgh"});
+            test.execute(Pop{4});
+            test.execute(Peek{"efgh"});
+            test.execute(WriteBuffer{"ijkl"}.with_bytes_written(4));
+            test.execute(ReadBuffers{"efghij"});
+            test.execute(Peek{"kl"});
+
+            test.execute(EndInput{});
+            test.execute(WriteBuffer{"mno"}.with_bytes_written(0));
+            test.execute(Pop{2});
+            test.execute(Eof{true});
+            test.execute(BytesWritten{12});
+            test.execute(BytesRead{12});
+        }
+
+        // a Buffer that fits while the ring is empty passes through the stream by reference
+        {
+            ByteStream stream{64 * 1024};
+            const Buffer payload{string(60000, 'x')};
+            if (stream.write(payload) != payload.size()) {
+                throw runtime_error("write(Buffer) did not accept the whole payload");
+            }
+
+            const BufferList chunks = stream.read_buffers(1000);
+            if (chunks.size() != 1000 or chunks.buffers().size() != 1 or
+                chunks.buffers().front().str().data() != payload.str().data()) {
+                throw runtime_error("read_buffers() did not return a slice of the written Buffer");
+            }
+            if (stream.buffer_size() != payload.size() - 1000 or stream.remaining_capacity() != 64 * 1024 - 59000) {
+                throw runtime_error("chunk bytes were not accounted for exactly");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
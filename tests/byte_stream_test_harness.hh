@@ -56,6 +56,16 @@ struct Write : public ByteStreamAction {
     void execute(ByteStream &) const override;
 };
 
+struct WriteBuffer : public ByteStreamAction {
+    std::string _data;
+    std::optional<size_t> _bytes_written{};
+
+    WriteBuffer(const std::string &data);
+    WriteBuffer &with_bytes_written(const size_t bytes_written);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
 struct Pop : public ByteStreamAction {
     size_t _len;
 
@@ -128,6 +138,22 @@ struct Peek : public ByteStreamExpectation {
     void execute(ByteStream &) const override;
 };
 
+struct PeekViews : public ByteStreamExpectation {
+    std::string _output;
+
+    PeekViews(const std::string &output);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
+struct ReadBuffers : public ByteStreamAction {
+    std::string _output;
+
+    ReadBuffers(const std::string &output);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
 class ByteStreamTestHarness {
     std::string _test_name;
     ByteStream _byte_stream;
@@ -0,0 +1,448 @@
+#include "eventloop.hh"
+#include "file_descriptor.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <fcntl.h>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// {read end, write end}
+static pair<FileDescriptor, FileDescriptor> make_pipe() {
+    int fds[2];
+    SystemCall("pipe", ::pipe(fds));
+    return {FileDescriptor{fds[0]}, FileDescriptor{fds[1]}};
+}
+
+static void check_backend(const EventLoop::Backend backend) {
+    // a readable pipe runs its callback, and a hangup cancels the rule
+    {
+        EventLoop loop{backend};
+        auto [reader, writer] = make_pipe();
+        string received;
+        bool canceled = false;
+        loop.add_rule(
+            reader, Direction::In, [&] { received += reader.read(); }, [] { return true; }, [&] { canceled = true; });
+
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, "idle pipe did not time out");
+        writer.write("hello");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success, "readable pipe was not reported");
+        test_err_if(received != "hello", "callback did not read the pipe");
+
+        // poll and epoll both report a hangup on an empty pipe without saying it is readable
+        writer.close();
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success, "hangup was not reported");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit, "loop did not exit after hangup");
+        test_err_if(not canceled, "cancel callback was not called");
+    }
+
+    // interest turns a rule on and off between waits, and a loop with no interested rule exits
+    {
+        EventLoop loop{backend};
+        auto [reader, writer] = make_pipe();
+        bool wants_to_write = false;
+        unsigned writes = 0;
+        loop.add_rule(
+            writer,
+            Direction::Out,
+            [&] {
+                writer.write("x");
+                ++writes;
+                wants_to_write = false;
+            },
+            [&] { return wants_to_write; });
+
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit, "uninterested rule was waited for");
+        wants_to_write = true;
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success, "interested writer was not run");
+        test_err_if(writes != 1 or reader.read() != "x", "writer callback did not write once");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit, "rule stayed interested");
+        wants_to_write = true;
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success, "rule was not re-armed");
+        test_err_if(writes != 2, "writer callback did not run again");
+    }
+
+    // a rule that loses interest while armed, without being run, no longer keeps the loop waiting
+    {
+        EventLoop loop{backend};
+        auto [reader, writer] = make_pipe();
+        bool wants_to_read = true;
+        loop.add_rule(
+            reader, Direction::In, [&] { reader.read(); }, [&] { return wants_to_read; });
+
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, "interested reader was not waited for");
+        wants_to_read = false;
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit, "armed but uninterested rule was waited for");
+        wants_to_read = true;
+        writer.write("x");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success, "reader did not regain interest");
+    }
+
+    // only the ready fd among many idle ones runs its callback
+    {
+        EventLoop loop{backend};
+        vector<pair<FileDescriptor, FileDescriptor>> pipes;
+        vector<unsigned> reads(256, 0);
+        pipes.reserve(reads.size());
+        for (size_t i = 0; i < reads.size(); ++i) {
+            pipes.push_back(make_pipe());
+            FileDescriptor &reader = pipes.back().first;
+            loop.add_rule(reader, Direction::In, [&reads, &reader, i] {
+                reader.read();
+                ++reads[i];
+            });
+        }
+        bool wrote = false;
+        FileDescriptor &writer = pipes[100].second;
+        loop.add_rule(
+            writer,
+            Direction::Out,
+            [&] {
+                writer.write("ping");
+                wrote = true;
+            },
+            [&] { return not wrote; });
+
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success, "writable pipe was not reported");
+        test_err_if(not wrote, "writer callback did not run");
+
+        // io_uring may already have seen the write complete its poll on the reading end
+        if (reads[100] == 0) {
+            test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success, "readable pipe was not reported");
+        }
+        for (size_t i = 0; i < reads.size(); ++i) {
+            test_err_if(reads[i] != (i == 100), "callback ran for the wrong fd");
+        }
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, "idle pipes did not time out");
+    }
+
+    // a reading and a writing rule on one fd are armed and run independently
+    {
+        EventLoop loop{backend};
+        int fds[2];
+        SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+        FileDescriptor socket{fds[0]}, peer{fds[1]};
+        string received;
+        string to_send;
+        loop.add_rule(socket, Direction::In, [&] { received += socket.read(); });
+        loop.add_rule(
+            socket,
+            Direction::Out,
+            [&] { to_send.erase(0, socket.write(to_send)); },
+            [&] { return not to_send.empty(); });
+
+        to_send = "request";
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success, "writable socket was not reported");
+        test_err_if(not to_send.empty() or peer.read() != "request", "writing rule did not write");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, "idle socket did not time out");
+
+        peer.write("response");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success, "readable socket was not reported");
+        test_err_if(received != "response", "reading rule did not read");
+
+        // EOF on the reading rule leaves the writing rule in place
+        SystemCall("shutdown", ::shutdown(peer.fd_num(), SHUT_WR));
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success, "EOF was not reported");
+        test_err_if(not socket.eof(), "reading rule did not see EOF");
+        to_send = "more";
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success, "writing rule was not run after EOF");
+        test_err_if(peer.read() != "more", "writing rule did not write after EOF");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit, "loop did not exit");
+    }
+
+    // closing an fd from another rule's callback cancels the rules on it
+    {
+        EventLoop loop{backend};
+        auto [reader, writer] = make_pipe();
+        auto [other_reader, other_writer] = make_pipe();
+        bool canceled = false;
+        loop.add_rule(
+            other_reader, Direction::In, [&] { other_reader.read(); }, [] { return true; }, [&] { canceled = true; });
+        loop.add_rule(reader, Direction::In, [&] {
+            reader.read();
+            other_reader.close();
+        });
+
+        writer.write("x");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success, "readable pipe was not reported");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, "remaining pipe did not time out");
+        test_err_if(not canceled, "rule on a closed fd was not canceled");
+    }
+
+    // an fd closed outside any loop cancels its rules in every loop, and an fd already at EOF cancels a new rule
+    {
+        EventLoop loop{backend}, other_loop{backend};
+        auto [reader, writer] = make_pipe();
+        auto [idle_reader, idle_writer] = make_pipe();
+        unsigned canceled = 0;
+        loop.add_rule(
+            reader, Direction::In, [&] { reader.read(); }, [] { return true; }, [&] { ++canceled; });
+        other_loop.add_rule(
+            reader, Direction::In, [&] { reader.read(); }, [] { return true; }, [&] { ++canceled; });
+        loop.add_rule(idle_reader, Direction::In, [&] { idle_reader.read(); });
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, "idle pipes did not time out");
+
+        reader.close();
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, "remaining pipe did not time out");
+        test_err_if(other_loop.wait_next_event(0) != EventLoop::Result::Exit, "other loop did not exit");
+        test_err_if(canceled != 2, "rules on a closed fd were not canceled in every loop");
+
+        idle_writer.close();
+        idle_reader.read();
+        test_err_if(not idle_reader.eof(), "pipe did not reach EOF");
+        other_loop.add_rule(
+            idle_reader, Direction::In, [&] { idle_reader.read(); }, [] { return true; }, [&] { ++canceled; });
+        test_err_if(other_loop.wait_next_event(0) != EventLoop::Result::Exit, "rule on an fd at EOF was waited for");
+        test_err_if(canceled != 3, "rule on an fd at EOF was not canceled");
+    }
+
+    // a receive rule is given each datagram whole, however many are waiting
+    {
+        EventLoop loop{backend};
+        int fds[2];
+        SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_DGRAM, 0, fds));
+        FileDescriptor socket{fds[0]}, peer{fds[1]};
+        vector<string> datagrams;
+        loop.add_receive_rule(socket, [&](string_view datagram) { datagrams.emplace_back(datagram); });
+
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, "idle socket did not time out");
+        const vector<string> sent{"one", string(1500, 'x'), "three", string(EventLoop::RECEIVE_SIZE - 1000, 'y')};
+        for (const string &datagram : sent) {
+            peer.write(datagram);
+        }
+        for (unsigned waits = 0; datagrams.size() < sent.size() and waits < 10; ++waits) {
+            test_err_if(loop.wait_next_event(1000) != EventLoop::Result::Success, "datagrams were not reported");
+        }
+        test_err_if(datagrams != sent, "receive rule was not given the datagrams in order");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, "drained socket did not time out");
+    }
+
+    // a receive rule on a pipe is given the bytes written, and is canceled at EOF
+    {
+        EventLoop loop{backend};
+        auto [reader, writer] = make_pipe();
+        string received;
+        bool canceled = false;
+        loop.add_receive_rule(
+            reader, [&](string_view bytes) { received += bytes; }, [&] { canceled = true; });
+
+        writer.write("hello, ");
+        test_err_if(loop.wait_next_event(1000) != EventLoop::Result::Success, "readable pipe was not reported");
+        writer.write("world");
+        writer.close();
+        for (unsigned waits = 0; not canceled and waits < 10; ++waits) {
+            loop.wait_next_event(1000);
+        }
+        test_err_if(received != "hello, world", "receive rule was not given the bytes written");
+        test_err_if(not canceled, "receive rule was not canceled at EOF");
+        test_err_if(not reader.eof(), "receive rule did not record EOF on its fd");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit, "loop did not exit after EOF");
+    }
+
+    // timers run in order of deadline, a loop with only timers waits for them, and a canceled timer never runs
+    {
+        EventLoop loop{backend};
+        string order;
+        const auto begin = timestamp_ms();
+        loop.add_timer(30, [&] { order += "b"; });
+        loop.add_timer(10, [&] { order += "a"; });
+        const auto canceled = loop.add_timer(20, [&] { order += "x"; });
+        test_err_if(not loop.cancel_timer(canceled), "pending timer was not canceled");
+        test_err_if(loop.cancel_timer(canceled), "canceled timer was canceled again");
+
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, "timer ran before its deadline");
+        while (order.size() < 2) {
+            test_err_if(loop.wait_next_event(-1) != EventLoop::Result::Success, "loop did not wait for its timers");
+        }
+        test_err_if(order != "ab", "timers did not run in order of deadline");
+        test_err_if(timestamp_ms() - begin < 30, "timer ran before its deadline");
+        test_err_if(loop.wait_next_event(-1) != EventLoop::Result::Exit, "loop did not exit after its timers");
+    }
+
+    // a timer cuts an indefinite wait short, runs after the ready fds, and can add rules and timers
+    {
+        EventLoop loop{backend};
+        auto [reader, writer] = make_pipe();
+        string events;
+        loop.add_rule(reader, Direction::In, [&] { events += reader.read(); });
+        loop.add_timer(0, [&] {
+            events += "t";
+            loop.add_timer(5, [&] {
+                events += "u";
+                writer.write("w");
+            });
+        });
+
+        writer.write("r");
+        test_err_if(loop.wait_next_event(-1) != EventLoop::Result::Success, "wait did not succeed");
+        test_err_if(events != "rt", "timer did not run after the ready fd");
+        while (events.size() < 4) {
+            test_err_if(loop.wait_next_event(-1) != EventLoop::Result::Success, "timer did not end the wait");
+        }
+        test_err_if(events != "rtuw", "timer added by a timer did not run");
+    }
+
+    // a timer beyond a finite timeout leaves it a plain timeout
+    {
+        EventLoop loop{backend};
+        bool ran = false;
+        loop.add_timer(100000, [&] { ran = true; });
+        const auto begin = timestamp_ms();
+        test_err_if(loop.wait_next_event(20) != EventLoop::Result::Timeout, "wait did not time out");
+        test_err_if(timestamp_ms() - begin < 20 or ran, "wait ended before its timeout");
+    }
+
+    // ready fds take turns at being run first, and each rule counts its callbacks
+    {
+        EventLoop loop{backend};
+        vector<pair<FileDescriptor, FileDescriptor>> pipes;
+        pipes.reserve(3);
+        string order;
+        vector<shared_ptr<const EventLoop::RuleCounters>> counters;
+        for (char name = 'a'; name < 'd'; ++name) {
+            pipes.push_back(make_pipe());
+            FileDescriptor &reader = pipes.back().first;
+            pipes.back().second.write("xxx");
+            counters.push_back(loop.add_rule(reader, Direction::In, [&reader, &order, name] {
+                reader.read(1);
+                order += name;
+            }));
+        }
+
+        set<char> firsts;
+        for (unsigned waits = 0; waits < 3; ++waits) {
+            order.clear();
+            while (order.size() < 3) {
+                test_err_if(loop.wait_next_event(1000) != EventLoop::Result::Success, "pipes were not reported");
+            }
+            firsts.insert(order.front());
+        }
+        // io_uring runs completions in the order the kernel posts them
+        test_err_if(loop.backend() != EventLoop::Backend::IoUring and firsts.size() != 3,
+                    "the same fd was run first on every wait");
+        for (const auto &rule_counters : counters) {
+            test_err_if(rule_counters->callbacks != 3, "rule did not count its callbacks");
+        }
+    }
+
+    // a receive rule reads no more than its budget in one wait, and counts what it was given
+    {
+        EventLoop loop{backend};
+        int fds[2];
+        SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_DGRAM, 0, fds));
+        FileDescriptor by_reads{fds[0]}, by_reads_peer{fds[1]};
+        SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_DGRAM, 0, fds));
+        FileDescriptor by_bytes{fds[0]}, by_bytes_peer{fds[1]};
+
+        size_t read_datagrams = 0, byte_datagrams = 0;
+        const auto read_counters = loop.add_receive_rule(
+            by_reads, [&](string_view) { ++read_datagrams; }, [] {}, {4, SIZE_MAX});
+        const auto byte_counters = loop.add_receive_rule(
+            by_bytes, [&](string_view) { ++byte_datagrams; }, [] {}, {100, 250});
+        for (unsigned i = 0; i < 10; ++i) {
+            by_reads_peer.write(string(100, 'r'));
+            by_bytes_peer.write(string(100, 'b'));
+        }
+
+        if (loop.backend() != EventLoop::Backend::IoUring) {
+            // 250 bytes take three datagrams of 100
+            for (const auto &[reads, bytes] : {pair{4, 3}, pair{8, 6}, pair{10, 9}, pair{10, 10}}) {
+                test_err_if(loop.wait_next_event(1000) != EventLoop::Result::Success, "datagrams were not reported");
+                test_err_if(read_datagrams != size_t(reads), "read budget was not kept to");
+                test_err_if(byte_datagrams != size_t(bytes), "byte budget was not kept to");
+            }
+            test_err_if(read_counters->budget_spent != 2 or byte_counters->budget_spent != 3,
+                        "spent budgets were not counted");
+        }
+        for (unsigned waits = 0; (read_datagrams < 10 or byte_datagrams < 10) and waits < 10; ++waits) {
+            loop.wait_next_event(1000);
+        }
+        test_err_if(read_counters->callbacks != 10 or read_counters->bytes != 1000, "datagrams were not counted");
+        test_err_if(byte_counters->callbacks != 10 or byte_counters->bytes != 1000, "datagrams were not counted");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, "drained sockets did not time out");
+        test_err_if(::fcntl(by_reads.fd_num(), F_GETFL) & O_NONBLOCK, "a budget made the app's fd non-blocking");
+    }
+
+    // a budget that allows nothing to be read is refused
+    {
+        EventLoop loop{backend};
+        auto [reader, writer] = make_pipe();
+        for (const EventLoop::Budget budget : {EventLoop::Budget{0, SIZE_MAX}, EventLoop::Budget{1, 0}}) {
+            bool threw = false;
+            try {
+                loop.add_receive_rule(
+                    reader, [](string_view) {}, [] {}, budget);
+            } catch (const invalid_argument &) {
+                threw = true;
+            }
+            test_err_if(not threw, "an empty budget was accepted");
+        }
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit, "a refused rule was added");
+    }
+
+    // a budgeted receive rule stops, without blocking, when fd runs dry, and reads on to EOF
+    {
+        EventLoop loop{backend};
+        auto [reader, writer] = make_pipe();
+        string received;
+        bool canceled = false;
+        loop.add_receive_rule(
+            reader, [&](string_view bytes) { received += bytes; }, [&] { canceled = true; }, {8, SIZE_MAX});
+
+        writer.write("hello");
+        test_err_if(loop.wait_next_event(1000) != EventLoop::Result::Success, "readable pipe was not reported");
+        test_err_if(received != "hello", "receive rule was not given the bytes written");
+        if (loop.backend() != EventLoop::Backend::IoUring) {
+            test_err_if(reader.read_count() != 1, "an empty pipe was read");
+        }
+
+        writer.write(" world");
+        writer.close();
+        for (unsigned waits = 0; not canceled and waits < 10; ++waits) {
+            loop.wait_next_event(1000);
+        }
+        test_err_if(received != "hello world" or not canceled, "receive rule did not read on to EOF");
+    }
+
+    // a callback that neither reads nor loses interest is a busy wait
+    {
+        EventLoop loop{backend};
+        auto [reader, writer] = make_pipe();
+        loop.add_rule(reader, Direction::In, [] {});
+        writer.write("x");
+        bool threw = false;
+        try {
+            loop.wait_next_event(0);
+        } catch (const runtime_error &) {
+            threw = true;
+        }
+        test_err_if(not threw, "busy wait was not detected");
+    }
+}
+
+int main() {
+    try {
+        check_backend(EventLoop::Backend::Poll);
+        check_backend(EventLoop::Backend::Epoll);
+
+        // without io_uring (in the build or the kernel) this is Backend::Epoll again
+        check_backend(EventLoop::Backend::IoUring);
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
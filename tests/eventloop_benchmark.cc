@@ -0,0 +1,188 @@
+#include "address.hh"
+#include "eventloop.hh"
+#include "file_descriptor.hh"
+#include "socket.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t WAITS = 20000;
+static constexpr size_t DATAGRAMS = 1 << 16;
+static constexpr size_t BURST = 64;
+
+// {read end, write end}
+static pair<FileDescriptor, FileDescriptor> make_pipe() {
+    int fds[2];
+    SystemCall("pipe", ::pipe(fds));
+    return {FileDescriptor{fds[0]}, FileDescriptor{fds[1]}};
+}
+
+// One pipe has a byte written to it before every wait, and `idle` more pipes never become readable
+double microseconds_per_wait(const size_t idle, const EventLoop::Backend backend) {
+    EventLoop loop{backend};
+    vector<pair<FileDescriptor, FileDescriptor>> pipes;
+    pipes.reserve(idle);
+    for (size_t i = 0; i < idle; ++i) {
+        pipes.push_back(make_pipe());
+        FileDescriptor &reader = pipes.back().first;
+        loop.add_rule(reader, Direction::In, [&reader] { reader.read(); });
+    }
+
+    auto [reader, writer] = make_pipe();
+    size_t reads = 0;
+    string buffer;
+    loop.add_rule(reader, Direction::In, [&] {
+        reader.read(buffer);
+        ++reads;
+    });
+
+    const auto begin = chrono::steady_clock::now();
+    for (size_t i = 0; i < WAITS; ++i) {
+        writer.write("x");
+        if (loop.wait_next_event(-1) != EventLoop::Result::Success) {
+            throw runtime_error("eventloop_benchmark: wait did not succeed");
+        }
+    }
+    const auto end = chrono::steady_clock::now();
+
+    if (reads != WAITS) {
+        throw runtime_error("eventloop_benchmark: lost a wakeup");
+    }
+    return chrono::duration<double, micro>(end - begin).count() / double(WAITS);
+}
+
+static const char *name(const EventLoop::Backend backend) {
+    switch (backend) {
+        case EventLoop::Backend::Epoll:
+            return "epoll";
+        case EventLoop::Backend::IoUring:
+            return "io_uring";
+        default:
+            return "poll";
+    }
+}
+
+// Bursts of `burst` UDP datagrams are sent over loopback to a receive rule; only the receiving
+// loop's system calls are counted, and the time includes the sender's.
+void datagrams_received(const size_t burst, const EventLoop::Backend backend) {
+    EventLoop loop{backend};
+    UDPSocket receiver;
+    receiver.bind(Address{"127.0.0.1", 0});
+    UDPSocket sender;
+    sender.connect(receiver.local_address());
+
+    size_t received = 0;
+    loop.add_receive_rule(receiver, [&](string_view datagram) { received += not datagram.empty(); });
+
+    const string payload(1200, 'x');
+    uint64_t system_calls = 0;
+    const auto begin = chrono::steady_clock::now();
+    for (size_t sent = 0; sent < DATAGRAMS; sent += burst) {
+        for (size_t i = 0; i < burst; ++i) {
+            sender.send(payload);
+        }
+        const uint64_t before = system_call_count();
+        while (received < sent + burst) {
+            if (loop.wait_next_event(-1) != EventLoop::Result::Success) {
+                throw runtime_error("eventloop_benchmark: wait did not succeed");
+            }
+        }
+        system_calls += system_call_count() - before;
+    }
+    const auto end = chrono::steady_clock::now();
+
+    cout << setw(10) << burst << setw(10) << name(loop.backend()) << setw(16)
+         << double(system_calls) / double(DATAGRAMS) << setw(14)
+         << chrono::duration<double, nano>(end - begin).count() / double(DATAGRAMS) << "\n";
+}
+
+// A hot UDP socket is sent BURST datagrams for each one sent to a quiet socket, and its receive rule
+// reads at most `reads` of them per wait; the time from the start of a wait to the quiet rule's
+// callback is measured
+void quiet_latency(const unsigned reads, const EventLoop::Backend backend) {
+    EventLoop loop{backend};
+    UDPSocket hot, quiet;
+    hot.bind(Address{"127.0.0.1", 0});
+    quiet.bind(Address{"127.0.0.1", 0});
+    UDPSocket hot_sender, quiet_sender;
+    hot_sender.connect(hot.local_address());
+    quiet_sender.connect(quiet.local_address());
+
+    chrono::steady_clock::time_point received{};
+    loop.add_receive_rule(hot, [](string_view) {}, [] {}, {reads, SIZE_MAX});
+    loop.add_receive_rule(quiet, [&](string_view) { received = chrono::steady_clock::now(); });
+
+    const string payload(1200, 'x');
+    vector<double> latencies{};
+    for (size_t round = 0; round < WAITS / 10; ++round) {
+        for (size_t i = 0; i < BURST; ++i) {
+            hot_sender.send(payload);
+        }
+        quiet_sender.send(payload);
+
+        received = {};
+        const auto begin = chrono::steady_clock::now();
+        while (received == chrono::steady_clock::time_point{}) {
+            if (loop.wait_next_event(-1) != EventLoop::Result::Success) {
+                throw runtime_error("eventloop_benchmark: wait did not succeed");
+            }
+        }
+        latencies.push_back(chrono::duration<double, micro>(received - begin).count());
+    }
+
+    sort(latencies.begin(), latencies.end());
+    const double mean = accumulate(latencies.begin(), latencies.end(), 0.0) / double(latencies.size());
+    cout << setw(10) << (reads == UINT_MAX ? string("all") : to_string(reads)) << setw(10) << name(loop.backend())
+         << setw(12) << mean << setw(12) << latencies[latencies.size() * 99 / 100] << "\n";
+}
+
+int main() {
+    try {
+        cout << fixed << setprecision(2);
+        cout << setw(10) << "idle fds" << setw(16) << "poll us/wait" << setw(16) << "epoll us/wait"
+             << "\n";
+        for (const size_t idle : {0, 16, 1024, 8192}) {
+            cout << setw(10) << idle << setw(16) << microseconds_per_wait(idle, EventLoop::Backend::Poll)
+                 << setw(16) << microseconds_per_wait(idle, EventLoop::Backend::Epoll) << "\n";
+        }
+
+        cout << "\nUDP datagrams through a receive rule\n";
+        cout << setw(10) << "burst" << setw(10) << "backend" << setw(16) << "syscalls/pkt" << setw(14) << "ns/pkt"
+             << "\n";
+        for (const size_t burst : {1, 16, 64}) {
+            for (const auto backend :
+                 {EventLoop::Backend::Poll, EventLoop::Backend::Epoll, EventLoop::Backend::IoUring}) {
+                datagrams_received(burst, backend);
+            }
+        }
+
+        cout << "\nQuiet UDP flow beside a flood of " << BURST << " datagrams per quiet one\n";
+        cout << setw(10) << "hot reads" << setw(10) << "backend" << setw(12) << "mean us" << setw(12) << "p99 us"
+             << "\n";
+        for (const unsigned reads : {1U, 16U, UINT_MAX}) {
+            for (const auto backend : {EventLoop::Backend::Poll, EventLoop::Backend::Epoll}) {
+                quiet_latency(reads, backend);
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
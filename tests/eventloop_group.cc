@@ -0,0 +1,212 @@
+#include "address.hh"
+#include "eventloop.hh"
+#include "eventloop_group.hh"
+#include "socket.hh"
+#include "test_err_if.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <list>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t LOOPS = 4;
+
+// Wait up to five seconds for `done` to hold
+template <typename PredicateT>
+static bool wait_until(const PredicateT &done) {
+    const auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+    while (not done()) {
+        if (chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    return true;
+}
+
+int main() {
+    try {
+        // several producers, one consumer: nothing is lost, and each producer's tasks come out in order
+        {
+            constexpr size_t PRODUCERS = 4;
+            constexpr size_t TASKS = 100000;
+            EventLoopGroup::TaskQueue queue;
+            vector<size_t> last(PRODUCERS, 0);
+            bool in_order = true;
+
+            vector<thread> producers{};
+            for (size_t p = 0; p < PRODUCERS; ++p) {
+                producers.emplace_back([&, p] {
+                    for (size_t i = 1; i <= TASKS; ++i) {
+                        queue.push([&, p, i](EventLoop &) {
+                            in_order &= last[p] + 1 == i;
+                            last[p] = i;
+                        });
+                    }
+                });
+            }
+
+            EventLoop loop{};
+            size_t popped = 0;
+            EventLoopGroup::TaskT task{};
+            while (popped < PRODUCERS * TASKS) {
+                if (queue.pop(task)) {
+                    task(loop);
+                    ++popped;
+                }
+            }
+            for (auto &producer : producers) {
+                producer.join();
+            }
+            test_err_if(queue.pop(task), "queue had more tasks than were pushed");
+            test_err_if(not in_order, "a producer's tasks came out of order");
+        }
+
+        // tasks run on their loop's own thread, in order, and can hand work on to another loop
+        {
+            EventLoopGroup group{LOOPS};
+            test_err_if(group.size() != LOOPS, "group has the wrong number of loops");
+
+            vector<thread::id> threads(LOOPS);
+            vector<vector<unsigned>> order(LOOPS);
+            atomic<size_t> done{0};
+            for (size_t i = 0; i < LOOPS; ++i) {
+                for (unsigned n = 0; n < 100; ++n) {
+                    group.post(i, [&, i, n](EventLoop &) {
+                        threads[i] = this_thread::get_id();
+                        order[i].push_back(n);
+                        if (n == 99) {
+                            // hand off to the next loop, which finishes the job
+                            group.post((i + 1) % LOOPS, [&](EventLoop &) { ++done; });
+                        }
+                    });
+                }
+            }
+            test_err_if(not wait_until([&] { return done == LOOPS; }), "handed-off tasks did not run");
+            test_err_if(set<thread::id>(threads.begin(), threads.end()).size() != LOOPS,
+                        "loops did not run on threads of their own");
+            for (const auto &loop_order : order) {
+                for (unsigned n = 0; n < loop_order.size(); ++n) {
+                    test_err_if(loop_order[n] != n, "a loop's tasks ran out of order");
+                }
+            }
+
+            // a task may add timers to its loop
+            atomic<bool> fired{false};
+            group.post(0, [&](EventLoop &loop) { loop.add_timer(1, [&] { fired = true; }); });
+            test_err_if(not wait_until([&] { return fired.load(); }), "timer added by a task did not run");
+        }
+
+        // a sharded listener echoes on every connection, and the kernel spreads them over the loops
+        {
+            vector<list<TCPSocket>> connections(LOOPS);  // outlives the group, whose loops use it
+            atomic<size_t> accepted[LOOPS] = {};
+            EventLoopGroup group{LOOPS};
+            const auto on_accept = [&](const size_t i, EventLoop &loop, TCPSocket &&accepted_socket) {
+                TCPSocket &connection = connections[i].emplace_back(move(accepted_socket));
+                loop.add_rule(connection, Direction::In, [&connection] { connection.write(connection.read()); });
+                ++accepted[i];
+            };
+            const Address address = group.listen(Address{"127.0.0.1", 0}, on_accept);
+
+            vector<TCPSocket> clients(64);
+            for (size_t i = 0; i < clients.size(); ++i) {
+                clients[i].connect(address);
+                clients[i].write("hello " + to_string(i));
+            }
+            for (size_t i = 0; i < clients.size(); ++i) {
+                string echoed;
+                while (echoed.size() < ("hello " + to_string(i)).size()) {
+                    echoed += clients[i].read();
+                }
+                test_err_if(echoed != "hello " + to_string(i), "connection was not echoed");
+            }
+
+            size_t loops_used = 0;
+            for (const auto &count : accepted) {
+                loops_used += count > 0;
+            }
+            test_err_if(loops_used < 2, "connections were not spread over the loops");
+        }
+
+        // sharded datagram sockets each answer on their own loop
+        {
+            EventLoopGroup group{LOOPS};
+            const auto echo = [](const size_t, EventLoop &loop, UDPSocket &socket) {
+                loop.add_rule(socket, Direction::In, [&socket] {
+                    const auto datagram = socket.recv();
+                    socket.sendto(datagram.source_address, datagram.payload);
+                });
+            };
+            const Address address = group.bind_datagrams(Address{"127.0.0.1", 0}, echo);
+
+            vector<UDPSocket> clients(16);
+            for (auto &client : clients) {
+                client.connect(address);
+                client.send("ping");
+            }
+            for (auto &client : clients) {
+                test_err_if(client.recv().payload != "ping", "datagram was not answered");
+            }
+        }
+
+        // an exception on a loop's thread ends the thread and comes out of stop()
+        {
+            EventLoopGroup group{2};
+            atomic<bool> thrown{false};
+            group.post(1, [&](EventLoop &) {
+                thrown = true;
+                throw runtime_error("from a task");
+            });
+            bool rethrown = false;
+            try {
+                test_err_if(not wait_until([&] { return thrown.load(); }), "throwing task did not run");
+                group.stop();
+            } catch (const runtime_error &e) {
+                rethrown = string(e.what()) == "from a task";
+            }
+            test_err_if(not rethrown, "stop() did not rethrow the exception of a loop's thread");
+
+            rethrown = false;
+            try {
+                group.stop();
+            } catch (const runtime_error &e) {
+                rethrown = string(e.what()) == "from a task";
+            }
+            test_err_if(not rethrown, "a second stop() dropped the exception of a loop's thread");
+        }
+
+        // stop() from a loop's own thread is refused, and leaves the group running
+        {
+            EventLoopGroup group{2};
+            atomic<bool> refused{false};
+            group.post(0, [&](EventLoop &) {
+                try {
+                    group.stop();
+                } catch (const runtime_error &) {
+                    refused = true;
+                }
+            });
+            test_err_if(not wait_until([&] { return refused.load(); }), "stop() from a loop's thread was not refused");
+
+            atomic<bool> ran{false};
+            group.post(1, [&](EventLoop &) { ran = true; });
+            test_err_if(not wait_until([&] { return ran.load(); }), "group stopped running after a refused stop()");
+            group.stop();
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,93 @@
+#include "address.hh"
+#include "eventloop.hh"
+#include "eventloop_group.hh"
+#include "socket.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t CLIENTS = 16;
+static constexpr size_t ROUND_TRIPS = 5000;  // per client
+static constexpr size_t MESSAGE_SIZE = 64;
+
+// Echo servers on `loops` loops behind one port; each client thread sends a message and waits for it
+// to come back, ROUND_TRIPS times, over its own loopback connection
+double round_trips_per_second(const size_t loops) {
+    vector<list<TCPSocket>> connections(loops);  // outlives the group, whose loops use it
+    EventLoopGroup group{loops};
+    const Address address =
+        group.listen(Address{"127.0.0.1", 0}, [&](const size_t i, EventLoop &loop, TCPSocket &&accepted) {
+            TCPSocket &connection = connections[i].emplace_back(move(accepted));
+            loop.add_rule(connection, Direction::In, [&connection] { connection.write(connection.read()); });
+        });
+
+    atomic<bool> failed{false};
+    vector<thread> clients{};
+    const auto begin = chrono::steady_clock::now();
+    for (size_t c = 0; c < CLIENTS; ++c) {
+        clients.emplace_back([&] {
+            try {
+                TCPSocket client;
+                client.connect(address);
+                const string message(MESSAGE_SIZE, 'x');
+                string echoed;
+                for (size_t i = 0; i < ROUND_TRIPS; ++i) {
+                    client.write(message);
+                    for (size_t received = 0; received < MESSAGE_SIZE; received += echoed.size()) {
+                        client.read(echoed, MESSAGE_SIZE - received);
+                        if (client.eof()) {
+                            throw runtime_error("eventloop_group_benchmark: server hung up");
+                        }
+                    }
+                }
+            } catch (const exception &) {
+                failed = true;
+            }
+        });
+    }
+    for (auto &client : clients) {
+        client.join();
+    }
+    const auto end = chrono::steady_clock::now();
+    group.stop();
+
+    if (failed) {
+        throw runtime_error("eventloop_group_benchmark: a client failed");
+    }
+    return double(CLIENTS * ROUND_TRIPS) / chrono::duration<double>(end - begin).count();
+}
+
+int main() {
+    try {
+        const size_t cpus = thread::hardware_concurrency();
+        cout << CLIENTS << " loopback echo clients, " << cpus << " CPUs\n";
+        cout << fixed << setprecision(0);
+        cout << setw(8) << "loops" << setw(16) << "round trips/s" << setw(10) << "speedup"
+             << "\n";
+
+        double single = 0;
+        for (size_t loops = 1; loops <= max<size_t>(cpus, 1); loops *= 2) {
+            const double rate = round_trips_per_second(loops);
+            single = loops == 1 ? rate : single;
+            cout << setw(8) << loops << setw(16) << rate << setw(10) << setprecision(2) << rate / single
+                 << setprecision(0) << "\n";
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -63,8 +63,8 @@ int main() {
             test.execute(BytesAssembled(2));
         }
 
-        {
-            ReassemblerTestHarness test{3};
+        for (const bool power_of_two_storage : {false, true}) {
+            ReassemblerTestHarness test{3, power_of_two_storage};
             for (unsigned int i = 0; i < 99997; i += 3) {
                 const string segment = {char(i), char(i + 1), char(i + 2), char(i + 13), char(i + 47), char(i + 9)};
                 test.execute(SubmitSegment{segment, i});
@@ -73,6 +73,19 @@ int main() {
             }
         }
 
+        for (const auto backend : {StreamReassembler::Backend::Intervals, StreamReassembler::Backend::Bitmap}) {
+            ReassemblerTestHarness test{5, true, backend};
+
+            test.execute(SubmitSegment{"bcdefgh", 1});
+            test.execute(BytesAssembled(0));
+            test.execute(UnassembledBytes(4));
+
+            test.execute(SubmitSegment{"a", 0});
+            test.execute(BytesAssembled(5));
+            test.execute(UnassembledBytes(0));
+            test.execute(BytesAvailable("abcde"));
+        }
+
     } catch (const exception &e) {
         cerr << "Exception: " << e.what() << endl;
         return EXIT_FAILURE;
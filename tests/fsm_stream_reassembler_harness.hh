@@ -5,11 +5,13 @@
 #include "stream_reassembler.hh"
 #include "util.hh"
 
+#include <array>
 #include <exception>
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
 
 class ReassemblerExpectationViolation : public std::runtime_error {
   public:
@@ -103,6 +105,46 @@ struct UnassembledBytes : public ReassemblerExpectation {
     }
 };
 
+struct RecentRanges : public ReassemblerExpectation {
+    std::vector<StreamReassembler::Range> _ranges;
+    size_t _max_ranges{StreamReassembler::MAX_RECENT_RANGES};
+
+    RecentRanges(std::vector<StreamReassembler::Range> ranges) : _ranges(std::move(ranges)) {}
+
+    RecentRanges &with_max_ranges(const size_t max_ranges) {
+        _max_ranges = max_ranges;
+        return *this;
+    }
+
+    static std::string ranges_to_string(const std::vector<StreamReassembler::Range> &ranges) {
+        std::ostringstream ss;
+        ss << "[";
+        for (const auto &[first, last] : ranges) {
+            ss << " [" << first << ", " << last << ")";
+        }
+        ss << " ]";
+        return ss.str();
+    }
+
+    std::string description() const {
+        std::ostringstream ss;
+        ss << "recent ranges = " << ranges_to_string(_ranges) << " (at most " << _max_ranges << ")";
+        return ss.str();
+    }
+
+    void execute(StreamReassembler &reassembler) const {
+        std::array<StreamReassembler::Range, StreamReassembler::MAX_RECENT_RANGES> ranges{};
+        const size_t count = reassembler.recent_ranges(ranges, _max_ranges);
+        const std::vector<StreamReassembler::Range> reported(ranges.begin(), ranges.begin() + count);
+        if (reported != _ranges) {
+            std::ostringstream ss;
+            ss << "The reassembler was expected to report the recent ranges " << ranges_to_string(_ranges)
+               << ", but it reported " << ranges_to_string(reported);
+            throw ReassemblerExpectationViolation(ss.str());
+        }
+    }
+};
+
 struct AtEof : public ReassemblerExpectation {
     AtEof() {}
     std::string description() const {
@@ -164,8 +206,14 @@ class ReassemblerTestHarness {
     std::vector<std::string> steps_executed;
 
   public:
-    ReassemblerTestHarness(const size_t capacity) : reassembler(capacity), steps_executed() {
-        steps_executed.emplace_back("Initialized (capacity = " + std::to_string(capacity) + ")");
+    ReassemblerTestHarness(const size_t capacity,
+                           const bool power_of_two_storage = false,
+                           const StreamReassembler::Backend backend = StreamReassembler::Backend::Intervals)
+        : reassembler(capacity, power_of_two_storage, backend), steps_executed() {
+        steps_executed.emplace_back(
+            "Initialized (capacity = " + std::to_string(capacity) + ", power_of_two_storage = " +
+            std::to_string(power_of_two_storage) +
+            ", backend = " + (backend == StreamReassembler::Backend::Bitmap ? "bitmap" : "intervals") + ")");
     }
 
     void execute(const ReassemblerTestStep &step) {
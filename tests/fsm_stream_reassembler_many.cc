@@ -28,7 +28,9 @@ int main() {
 
         // buffer a bunch of bytes, make sure we can empty and re-fill before calling close()
         for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
-            StreamReassembler buf{MAX_SEG_LEN * NSEGS};
+            const auto backend =
+                rep_no % 2 ? StreamReassembler::Backend::Bitmap : StreamReassembler::Backend::Intervals;
+            StreamReassembler buf{MAX_SEG_LEN * NSEGS, false, backend};
 
             vector<tuple<size_t, size_t>> seq_size;
             size_t offset = 0;
@@ -58,7 +60,9 @@ int main() {
 
         // insert EOF into a hole in the buffer
         for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
-            StreamReassembler buf{65'000};
+            const auto backend =
+                rep_no % 2 ? StreamReassembler::Backend::Bitmap : StreamReassembler::Backend::Intervals;
+            StreamReassembler buf{65'000, false, backend};
 
             const size_t size = 1024;
             string d(size, 0);
@@ -89,7 +93,9 @@ int main() {
 
         // insert EOF over previously queued data, require one of two possible correct actions
         for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
-            StreamReassembler buf{65'000};
+            const auto backend =
+                rep_no % 2 ? StreamReassembler::Backend::Bitmap : StreamReassembler::Backend::Intervals;
+            StreamReassembler buf{65'000, false, backend};
 
             const size_t size = 1024;
             string d(size, 0);
@@ -0,0 +1,76 @@
+#include "page_pool.hh"
+#include "stream_reassembler.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static void expect_pages(const PagePool &pool, const size_t expected, const string &when) {
+    const size_t pages = pool.pages_in_use();
+    if (pages != expected) {
+        throw runtime_error("expected " + to_string(expected) + " pages in use " + when + ", but there were " +
+                            to_string(pages));
+    }
+}
+
+int main() {
+    try {
+        // the output stream's ring takes its pages when bytes are first copied into it
+        const size_t stream = (1 << 20) / PagePool::PAGE_SIZE;
+        PagePool pool;
+
+        for (const auto backend : {StreamReassembler::Backend::Intervals, StreamReassembler::Backend::Bitmap}) {
+            // the bitmap backend also takes a page for each 32768 indices that hold members, until it is empty
+            const size_t bitmap = backend == StreamReassembler::Backend::Bitmap ? 1 : 0;
+
+            {
+                StreamReassembler reassembler{1 << 20, false, backend, pool};
+                expect_pages(pool, 0, "after construction");
+
+                // bytes that arrive in order go straight to the output stream
+                reassembler.push_substring(string(10000, 'a'), 0, false);
+                reassembler.push_substring(string(10000, 'b'), 10000, false);
+                expect_pages(pool, stream, "after in-order bytes");
+
+                // out-of-order bytes take the pages they land on, and only those
+                reassembler.push_substring(string(1, 'd'), 30000, false);
+                expect_pages(pool, stream + 1 + bitmap, "after one out-of-order byte");
+                reassembler.push_substring(string(5000, 'f'), 41000, false);
+                expect_pages(pool, stream + 3 + 2 * bitmap, "after a second out-of-order substring");
+
+                // filling the first hole hands back the pages that were assembled
+                reassembler.push_substring(string(10000, 'c'), 20000, false);
+                reassembler.push_substring(string(9999, 'e'), 30001, false);
+                if (reassembler.stream_out().bytes_written() != 40000 or reassembler.unassembled_bytes() != 5000) {
+                    throw runtime_error("reassembler assembled the wrong bytes");
+                }
+                expect_pages(pool, stream + 2 + 2 * bitmap, "after assembling up to the second substring");
+
+                // and once nothing is left to assemble, every page is handed back
+                reassembler.push_substring(string(6000, 'f'), 40000, true);
+                expect_pages(pool, stream, "after assembling everything");
+                if (reassembler.stream_out().read(46000) !=
+                    string(10000, 'a') + string(10000, 'b') + string(10000, 'c') + "d" + string(9999, 'e') +
+                        string(6000, 'f')) {
+                    throw runtime_error("reassembler assembled the wrong bytes");
+                }
+            }
+
+            {
+                StreamReassembler reassembler{1 << 20, false, backend, pool};
+                reassembler.push_substring(string(100000, 'x'), 1, false);
+                expect_pages(pool, 25 + 4 * bitmap, "after a large out-of-order substring");
+            }
+            expect_pages(pool, 0, "after destroying a reassembler with unassembled bytes");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
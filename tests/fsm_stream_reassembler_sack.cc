@@ -0,0 +1,87 @@
+#include "byte_stream.hh"
+#include "fsm_stream_reassembler_harness.hh"
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        for (const auto backend : {StreamReassembler::Backend::Intervals, StreamReassembler::Backend::Bitmap}) {
+            {
+                ReassemblerTestHarness test{64, false, backend};
+
+                test.execute(RecentRanges{{}});
+                test.execute(SubmitSegment{"cd", 2});
+                test.execute(RecentRanges{{{2, 4}}});
+                test.execute(SubmitSegment{"gh", 6});
+                test.execute(RecentRanges{{{6, 8}, {2, 4}}});
+
+                // filling the hole between the ranges reports the merged range once
+                test.execute(SubmitSegment{"ef", 4});
+                test.execute(RecentRanges{{{2, 8}}});
+
+                // once the bytes are assembled, there is nothing to report
+                test.execute(SubmitSegment{"ab", 0});
+                test.execute(BytesAssembled(8));
+                test.execute(RecentRanges{{}});
+
+                // in-order bytes are never reported
+                test.execute(SubmitSegment{"ij", 8});
+                test.execute(RecentRanges{{}});
+            }
+
+            {
+                ReassemblerTestHarness test{100, false, backend};
+
+                // a burst after a loss grows the same range instead of pushing out older ones
+                test.execute(SubmitSegment{"x", 10});
+                test.execute(SubmitSegment{"y", 11});
+                test.execute(SubmitSegment{"z", 12});
+                test.execute(RecentRanges{{{10, 13}}});
+
+                // only the most recent ranges are kept
+                test.execute(SubmitSegment{"a", 20});
+                test.execute(SubmitSegment{"b", 30});
+                test.execute(SubmitSegment{"c", 40});
+                test.execute(SubmitSegment{"d", 50});
+                test.execute(RecentRanges{{{50, 51}, {40, 41}, {30, 31}, {20, 21}}});
+                test.execute(RecentRanges{{{50, 51}, {40, 41}, {30, 31}}}.with_max_ranges(3));
+
+                // a retransmission into an older range moves it to the front
+                test.execute(SubmitSegment{"bb", 30});
+                test.execute(RecentRanges{{{30, 32}, {50, 51}, {40, 41}, {20, 21}}});
+
+                // a range that becomes contiguous drops out
+                test.execute(SubmitSegment{string(10, 'q'), 0});
+                test.execute(BytesAssembled(13));
+                test.execute(RecentRanges{{{30, 32}, {50, 51}, {40, 41}, {20, 21}}});
+                test.execute(SubmitSegment{string(7, 'q'), 13});
+                test.execute(BytesAssembled(21));
+                test.execute(RecentRanges{{{30, 32}, {50, 51}, {40, 41}}});
+            }
+
+            {
+                ReassemblerTestHarness test{100, false, backend};
+
+                // an assembled range does not push out a live one when the next range arrives
+                test.execute(SubmitSegment{"a", 20});
+                test.execute(SubmitSegment{"b", 30});
+                test.execute(SubmitSegment{"c", 40});
+                test.execute(SubmitSegment{"d", 10});
+                test.execute(SubmitSegment{string(10, 'q'), 0});
+                test.execute(BytesAssembled(11));
+                test.execute(SubmitSegment{"e", 50});
+                test.execute(RecentRanges{{{50, 51}, {40, 41}, {30, 31}, {20, 21}}});
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -28,7 +28,9 @@ int main() {
 
         // overlapping segments
         for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
-            StreamReassembler buf{NSEGS * MAX_SEG_LEN};
+            const auto backend =
+                rep_no % 4 >= 2 ? StreamReassembler::Backend::Bitmap : StreamReassembler::Backend::Intervals;
+            StreamReassembler buf{NSEGS * MAX_SEG_LEN, rep_no % 2 == 1, backend};
 
             vector<tuple<size_t, size_t>> seq_size;
             size_t offset = 0;
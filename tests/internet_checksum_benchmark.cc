@@ -0,0 +1,80 @@
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// The byte-at-a-time loop that InternetChecksum::add used before the word and vector kernels.
+uint16_t per_byte_checksum(const string &data) {
+    uint32_t sum = 0;
+    bool parity = false;
+    for (const char byte : data) {
+        uint16_t val = uint8_t(byte);
+        if (not parity) {
+            val <<= 8;
+        }
+        sum += val;
+        parity = !parity;
+    }
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return ~sum;
+}
+
+// Checksum `data` repeatedly (about 256 MB in total) and return the throughput in GB/s.
+template <typename Checksum>
+double gigabytes_per_second(const string &data, const Checksum &checksum) {
+    const size_t repetitions = max(size_t(1), (size_t(256) << 20) / data.size());
+    uint16_t total = 0;
+
+    const auto begin = chrono::steady_clock::now();
+    for (size_t i = 0; i < repetitions; ++i) {
+        total += checksum(data);
+    }
+    const auto end = chrono::steady_clock::now();
+
+    // keep the sums alive so that the loop isn't optimized away
+    if (total == 1) {
+        cerr << "";
+    }
+    return double(data.size() * repetitions) / chrono::duration<double, nano>(end - begin).count();
+}
+
+int main() {
+    try {
+        const auto kernel_checksum = [](const string &data) {
+            InternetChecksum checksum;
+            checksum.add(data);
+            return checksum.value();
+        };
+
+        cout << fixed << setprecision(2);
+        cout << setw(8) << "bytes" << setw(12) << "per-byte" << setw(12) << "portable" << setw(12) << "sse2"
+             << setw(12) << "avx2" << "   (GB/s)\n";
+        for (const size_t size : {20, 64, 1500, 64 << 10}) {
+            const string data(size, 'x');
+            cout << setw(8) << size << setw(12) << gigabytes_per_second(data, per_byte_checksum);
+            for (const auto kernel : {InternetChecksum::Kernel::Portable,
+                                      InternetChecksum::Kernel::SSE2,
+                                      InternetChecksum::Kernel::AVX2}) {
+                if (InternetChecksum::select_kernel(kernel)) {
+                    cout << setw(12) << gigabytes_per_second(data, kernel_checksum);
+                } else {
+                    cout << setw(12) << "n/a";
+                }
+            }
+            cout << "\n";
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,103 @@
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// The byte-at-a-time InternetChecksum that the word and vector kernels replaced, kept as the reference.
+// Its sum is widened to 64 bits: the original 32-bit sum overflowed after about 128 KB of 0xff bytes.
+class ReferenceChecksum {
+    uint64_t _sum;
+    bool _parity{};
+
+  public:
+    ReferenceChecksum(const uint32_t initial_sum) : _sum(initial_sum) {}
+
+    void add(const string_view data) {
+        for (size_t i = 0; i < data.size(); i++) {
+            uint16_t val = uint8_t(data[i]);
+            if (not _parity) {
+                val <<= 8;
+            }
+            _sum += val;
+            _parity = !_parity;
+        }
+    }
+
+    uint16_t value() const {
+        uint64_t ret = _sum;
+        while (ret > 0xffff) {
+            ret = (ret >> 16) + (ret & 0xffff);
+        }
+        return ~ret;
+    }
+};
+
+// Sum `data` in random chunks (with both implementations) and compare the results.
+void check(const string &data, const uint32_t initial_sum, mt19937 &rd) {
+    InternetChecksum checksum{initial_sum};
+    ReferenceChecksum reference{initial_sum};
+
+    size_t offset = 0;
+    while (offset < data.size()) {
+        const size_t len = uniform_int_distribution<size_t>{0, min(data.size() - offset, size_t(2000))}(rd);
+        const string_view chunk{data.data() + offset, len};
+        checksum.add(chunk);
+        reference.add(chunk);
+        offset += len;
+
+        if (checksum.value() != reference.value()) {
+            throw runtime_error("InternetChecksum disagrees with the byte-at-a-time reference after " +
+                                to_string(offset) + " of " + to_string(data.size()) + " bytes");
+        }
+    }
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        for (const auto kernel : {InternetChecksum::Kernel::Portable,
+                                  InternetChecksum::Kernel::SSE2,
+                                  InternetChecksum::Kernel::AVX2}) {
+            if (not InternetChecksum::select_kernel(kernel)) {
+                continue;
+            }
+
+            // random bytes at random (unaligned) offsets, in random chunks
+            for (unsigned int i = 0; i < 2000; i++) {
+                string data(uniform_int_distribution<size_t>{0, 5000}(rd), 0);
+                generate(data.begin(), data.end(), [&] { return char(rd()); });
+                check(data.substr(min(size_t(rd() % 8), data.size())), rd() % 2 ? 0 : uint32_t(rd() & 0xffff), rd);
+            }
+
+            // sums that are zero, or fold to the ones' complement zero (0xffff)
+            check(string(4096, char(0)), 0, rd);
+            check(string(4096, char(0xff)), 0, rd);
+            check(string(4097, char(0xff)), 0xffff, rd);
+
+            // long enough chunks that the vector kernels move their lanes into the sum more than once
+            string long_data(size_t(3) << 20, char(0xff));
+            generate(long_data.begin(), long_data.begin() + 4096, [&] { return char(rd()); });
+            InternetChecksum checksum;
+            ReferenceChecksum reference{0};
+            checksum.add(long_data);
+            reference.add(long_data);
+            if (checksum.value() != reference.value()) {
+                throw runtime_error("InternetChecksum disagrees with the reference on a long chunk");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -13,6 +13,8 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 struct ReceiverTestStep {
     virtual std::string to_string() const { return "ReceiverTestStep"; }
@@ -84,6 +86,97 @@ struct ExpectWindow : public ReceiverExpectation {
     }
 };
 
+struct ExpectAdvertisedWindow : public ReceiverExpectation {
+    uint16_t _window;
+
+    ExpectAdvertisedWindow(const uint16_t window) : _window(window) {}
+    std::string description() const { return "advertised window " + std::to_string(_window); }
+
+    void execute(TCPReceiver &receiver) const {
+        if (receiver.advertised_window() != _window) {
+            std::string reported = std::to_string(receiver.advertised_window());
+            std::string expected = std::to_string(_window);
+            throw ReceiverExpectationViolation("The TCPReceiver advertised window `" + reported +
+                                               "`, but it was expected to be `" + expected + "`");
+        }
+    }
+};
+
+struct ExpectWindowScale : public ReceiverExpectation {
+    uint8_t _window_scale;
+    std::optional<uint8_t> _peer_window_scale;
+
+    ExpectWindowScale(const uint8_t window_scale, const std::optional<uint8_t> peer_window_scale)
+        : _window_scale(window_scale), _peer_window_scale(peer_window_scale) {}
+    std::string description() const {
+        return "window scale " + std::to_string(_window_scale) + ", peer window scale " +
+               (_peer_window_scale ? std::to_string(*_peer_window_scale) : "none");
+    }
+
+    void execute(TCPReceiver &receiver) const {
+        if (receiver.window_scale() != _window_scale or receiver.peer_window_scale() != _peer_window_scale or
+            receiver.window_scaling() != _peer_window_scale.has_value()) {
+            std::string reported = std::to_string(receiver.window_scale()) + "/" +
+                                   (receiver.peer_window_scale() ? std::to_string(*receiver.peer_window_scale())
+                                                                 : "none");
+            throw ReceiverExpectationViolation("The TCPReceiver reported window scales `" + reported +
+                                               "`, but they were expected to be `" + description() + "`");
+        }
+    }
+};
+
+struct ExpectSackBlocks : public ReceiverExpectation {
+    std::vector<std::pair<uint32_t, uint32_t>> _blocks;
+    size_t _max_blocks{TCPOptions::MAX_SACK_BLOCKS};
+    bool _timestamps{false};
+
+    ExpectSackBlocks(std::vector<std::pair<uint32_t, uint32_t>> blocks) : _blocks(std::move(blocks)) {}
+
+    ExpectSackBlocks &with_max_blocks(const size_t max_blocks) {
+        _max_blocks = max_blocks;
+        return *this;
+    }
+
+    ExpectSackBlocks &with_timestamps() {
+        _timestamps = true;
+        return *this;
+    }
+
+    static std::string blocks_to_string(const std::vector<std::pair<uint32_t, uint32_t>> &blocks) {
+        std::ostringstream ss;
+        ss << "[";
+        for (const auto &[begin, end] : blocks) {
+            ss << " " << begin << ":" << end;
+        }
+        ss << " ]";
+        return ss.str();
+    }
+
+    std::string description() const {
+        return "SACK blocks " + blocks_to_string(_blocks) + " (at most " + std::to_string(_max_blocks) +
+               (_timestamps ? ", beside timestamps)" : ")");
+    }
+
+    void execute(TCPReceiver &receiver) const {
+        TCPOptions options;
+        if (_timestamps) {
+            options.timestamps = TCPOptions::Timestamps{};
+        }
+        receiver.sack_blocks(options, _max_blocks);
+        if (options.length() > TCPOptions::MAX_LENGTH) {
+            throw ReceiverExpectationViolation("The TCPReceiver filled in more SACK blocks than fit in the options");
+        }
+        std::vector<std::pair<uint32_t, uint32_t>> reported;
+        for (size_t i = 0; i < options.sack_block_count; i++) {
+            reported.emplace_back(options.sack_blocks[i].begin.raw_value(), options.sack_blocks[i].end.raw_value());
+        }
+        if (reported != _blocks) {
+            throw ReceiverExpectationViolation("The TCPReceiver reported SACK blocks " + blocks_to_string(reported) +
+                                               ", but " + blocks_to_string(_blocks) + " were expected");
+        }
+    }
+};
+
 struct ExpectUnassembledBytes : public ReceiverExpectation {
     size_t _n_bytes;
 
@@ -195,6 +288,8 @@ struct SegmentArrives : public ReceiverAction {
     WrappingInt32 seqno{0};
     WrappingInt32 ackno{0};
     uint16_t win{};
+    std::optional<uint8_t> window_scale{};
+    bool sack_permitted{};
     std::string data{};
     std::optional<Result> result{};
 
@@ -233,6 +328,16 @@ struct SegmentArrives : public ReceiverAction {
         return *this;
     }
 
+    SegmentArrives &with_window_scale(uint8_t window_scale_) {
+        window_scale = window_scale_;
+        return *this;
+    }
+
+    SegmentArrives &with_sack_permitted() {
+        sack_permitted = true;
+        return *this;
+    }
+
     SegmentArrives &with_data(std::string data_) {
         data = data_;
         return *this;
@@ -253,6 +358,8 @@ struct SegmentArrives : public ReceiverAction {
         seg.header().ackno = ackno;
         seg.header().seqno = seqno;
         seg.header().win = win;
+        seg.header().options.window_scale = window_scale;
+        seg.header().options.sack_permitted = sack_permitted;
         return seg;
     }
 
@@ -0,0 +1,103 @@
+#include "tcp_receiver.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static TCPSegment make_segment(const WrappingInt32 seqno, string payload, const bool syn, const bool fin) {
+    TCPSegment seg;
+    seg.header().seqno = seqno;
+    seg.header().syn = syn;
+    seg.header().fin = fin;
+    seg.payload() = move(payload);
+    return seg;
+}
+
+static void expect_same(const TCPReceiver &one_at_a_time, const TCPReceiver &batched, const string &when) {
+    if (one_at_a_time.ackno() != batched.ackno() or
+        one_at_a_time.unassembled_bytes() != batched.unassembled_bytes() or
+        one_at_a_time.window_size() != batched.window_size() or
+        one_at_a_time.stream_out().bytes_written() != batched.stream_out().bytes_written() or
+        one_at_a_time.stream_out().input_ended() != batched.stream_out().input_ended()) {
+        throw runtime_error("segments_received() disagreed with segment_received() " + when);
+    }
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        for (size_t round = 0; round < 2000; round++) {
+            // the whole stream fits in the window, so that taking a burst in stream order changes nothing
+            const size_t capacity = uniform_int_distribution<size_t>{1000, 20000}(rd);
+            const size_t length = uniform_int_distribution<size_t>{0, capacity}(rd);
+            const WrappingInt32 isn{round % 4 ? uniform_int_distribution<uint32_t>{}(rd) : UINT32_MAX - 100};
+            string data(length, 0);
+            generate(data.begin(), data.end(), [&] { return char(rd()); });
+
+            // cut the stream into segments, the first with the SYN and the last with the FIN
+            vector<TCPSegment> segments;
+            segments.push_back(make_segment(isn, "", true, length == 0));
+            for (size_t index = 0; index < length;) {
+                const size_t size = min(length - index, uniform_int_distribution<size_t>{1, 1460}(rd));
+                segments.push_back(make_segment(isn + uint32_t(index + 1), data.substr(index, size), false,
+                                                index + size == length));
+                index += size;
+            }
+
+            // reorder them within a few places, duplicate some, and send some before the SYN
+            for (size_t i = 0; i + 1 < segments.size(); i++) {
+                if (rd() % 3 == 0) {
+                    swap(segments[i], segments[min(segments.size() - 1, i + 1 + rd() % 4)]);
+                }
+            }
+            for (size_t i = 0; i < segments.size() / 4; i++) {
+                segments.push_back(segments[rd() % segments.size()]);
+                swap(segments.back(), segments[rd() % segments.size()]);
+            }
+
+            TCPReceiver one_at_a_time{capacity};
+            TCPReceiver batched{capacity};
+            for (size_t first = 0; first < segments.size();) {
+                const size_t size = min(segments.size() - first, uniform_int_distribution<size_t>{1, 64}(rd));
+                const vector<TCPSegment> burst(segments.begin() + first, segments.begin() + first + size);
+                for (const TCPSegment &seg : burst) {
+                    one_at_a_time.segment_received(seg);
+                }
+                batched.segments_received(burst);
+                expect_same(one_at_a_time, batched, "after a burst of " + to_string(size));
+                first += size;
+            }
+
+            if (one_at_a_time.stream_out().peek_output(length) != batched.stream_out().peek_output(length)) {
+                throw runtime_error("segments_received() assembled different bytes");
+            }
+        }
+
+        // a burst of nothing changes nothing
+        {
+            TCPReceiver receiver{1000};
+            receiver.segments_received({});
+            if (receiver.ackno().has_value()) {
+                throw runtime_error("an empty burst set the ackno");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,73 @@
+#include "tcp_receiver.hh"
+#include "tcp_segment.hh"
+#include "wrapping_integers.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t SEGMENT = 1460;
+static constexpr size_t SEGMENTS = 1 << 20;
+
+// Bursts of `batch` segments in stream order, except that every eighth pair is swapped
+double nanoseconds_per_segment(const size_t batch, const bool batched) {
+    const WrappingInt32 isn{12345};
+    TCPReceiver receiver{1 << 20};
+    TCPSegment syn;
+    syn.header().syn = true;
+    syn.header().seqno = isn;
+    receiver.segment_received(syn);
+
+    const string data(SEGMENT, 'x');
+    vector<TCPSegment> burst(batch);
+    for (TCPSegment &seg : burst) {
+        seg.payload() = string(data);
+    }
+
+    uint64_t index = 0;
+    const auto begin = chrono::steady_clock::now();
+    for (size_t sent = 0; sent < SEGMENTS; sent += batch) {
+        for (size_t i = 0; i < batch; i++) {
+            const size_t position = batch > 1 and i % 8 < 2 and i + 1 < batch ? i ^ 1 : i;
+            burst[position].header().seqno = wrap(index + i * SEGMENT + 1, isn);
+        }
+        if (batched) {
+            receiver.segments_received(burst);
+        } else {
+            for (const TCPSegment &seg : burst) {
+                receiver.segment_received(seg);
+            }
+        }
+        index += batch * SEGMENT;
+        receiver.stream_out().pop_output(receiver.stream_out().buffer_size());
+    }
+    const auto end = chrono::steady_clock::now();
+
+    if (receiver.stream_out().bytes_written() != index) {
+        throw runtime_error("recv_batch_benchmark: receiver lost bytes");
+    }
+    return chrono::duration<double, nano>(end - begin).count() / double(SEGMENTS);
+}
+
+int main() {
+    try {
+        cout << fixed << setprecision(1);
+        cout << setw(8) << "batch" << setw(22) << "one at a time ns/seg" << setw(18) << "batched ns/seg"
+             << "\n";
+        for (const size_t batch : {1, 8, 32, 64}) {
+            cout << setw(8) << batch << setw(22) << nanoseconds_per_segment(batch, false) << setw(18)
+                 << nanoseconds_per_segment(batch, true) << "\n";
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,82 @@
+#include "receiver_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            // without the SACK-permitted option, no blocks are reported
+            uint32_t isn = 23452;
+            TCPReceiverTestHarness test{4000};
+            test.execute(ExpectSackBlocks{{}});
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+            test.execute(
+                SegmentArrives{}.with_seqno(isn + 3).with_data("cd").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectUnassembledBytes{2});
+            test.execute(ExpectSackBlocks{{}});
+        }
+
+        {
+            // with it, each block covers received bytes beyond the ackno, the most recent first
+            uint32_t isn = 23452;
+            TCPReceiverTestHarness test{4000};
+            test.execute(SegmentArrives{}.with_syn().with_sack_permitted().with_seqno(isn).with_result(
+                SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{}});
+            test.execute(
+                SegmentArrives{}.with_seqno(isn + 3).with_data("cd").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{{isn + 3, isn + 5}}});
+            test.execute(
+                SegmentArrives{}.with_seqno(isn + 7).with_data("gh").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{{isn + 7, isn + 9}, {isn + 3, isn + 5}}});
+            test.execute(ExpectSackBlocks{{{isn + 7, isn + 9}}}.with_max_blocks(1));
+            test.execute(
+                SegmentArrives{}.with_seqno(isn + 1).with_data("ab").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectAckno{WrappingInt32{isn + 5}});
+            test.execute(ExpectSackBlocks{{{isn + 7, isn + 9}}});
+            test.execute(
+                SegmentArrives{}.with_seqno(isn + 5).with_data("ef").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{}});
+            test.execute(ExpectBytes{"abcdefgh"});
+        }
+
+        {
+            // block edges wrap around like any other sequence number
+            uint32_t isn = UINT32_MAX - 2;
+            TCPReceiverTestHarness test{4000};
+            test.execute(SegmentArrives{}.with_syn().with_sack_permitted().with_seqno(isn).with_result(
+                SegmentArrives::Result::OK));
+            test.execute(
+                SegmentArrives{}.with_seqno(isn + 2).with_data("bcd").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{{UINT32_MAX, 2}}});
+        }
+
+        {
+            // only as many blocks are filled in as fit beside the other options
+            uint32_t isn = 1000;
+            TCPReceiverTestHarness test{4000};
+            test.execute(SegmentArrives{}.with_syn().with_sack_permitted().with_seqno(isn).with_result(
+                SegmentArrives::Result::OK));
+            for (uint32_t offset : {11, 21, 31, 41}) {
+                test.execute(
+                    SegmentArrives{}.with_seqno(isn + offset).with_data("x").with_result(SegmentArrives::Result::OK));
+            }
+            test.execute(ExpectSackBlocks{
+                {{isn + 41, isn + 42}, {isn + 31, isn + 32}, {isn + 21, isn + 22}, {isn + 11, isn + 12}}});
+            test.execute(
+                ExpectSackBlocks{{{isn + 41, isn + 42}, {isn + 31, isn + 32}, {isn + 21, isn + 22}}}.with_timestamps());
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
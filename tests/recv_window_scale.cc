@@ -0,0 +1,103 @@
+#include "receiver_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            // small window, no window scale option: the window is advertised as it is
+            size_t cap = 4000;
+            uint32_t isn = 23452;
+            TCPReceiverTestHarness test{cap};
+            test.execute(ExpectWindowScale{0, {}});
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectWindowScale{0, {}});
+            test.execute(ExpectWindow{cap});
+            test.execute(ExpectAdvertisedWindow{4000});
+            test.execute(
+                SegmentArrives{}.with_seqno(isn + 1).with_data("abcd").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectAdvertisedWindow{3996});
+        }
+
+        {
+            // large window, no window scale option: the advertised window is clamped, not truncated
+            size_t cap = 1 << 20;
+            uint32_t isn = 1;
+            TCPReceiverTestHarness test{cap};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectWindowScale{5, {}});
+            test.execute(ExpectWindow{cap});
+            test.execute(ExpectAdvertisedWindow{65535});
+        }
+
+        {
+            // large window, window scaling negotiated: the advertised window is scaled, rounding down
+            size_t cap = 1 << 20;
+            uint32_t isn = 1;
+            TCPReceiverTestHarness test{cap};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_window_scale(7).with_result(
+                SegmentArrives::Result::OK));
+            test.execute(ExpectWindowScale{5, 7});
+            test.execute(ExpectWindow{cap});
+            test.execute(ExpectAdvertisedWindow{32768});
+            test.execute(
+                SegmentArrives{}.with_seqno(isn + 1).with_data("abcd").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectWindow{cap - 4});
+            test.execute(ExpectAdvertisedWindow{32767});
+            test.execute(ExpectBytes{"abcd"});
+            test.execute(ExpectAdvertisedWindow{32768});
+        }
+
+        {
+            // a capacity just over 64 KB needs a shift of one
+            size_t cap = 100000;
+            uint32_t isn = 0xffff'fff0;
+            TCPReceiverTestHarness test{cap};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_window_scale(0).with_result(
+                SegmentArrives::Result::OK));
+            test.execute(ExpectWindowScale{1, 0});
+            test.execute(ExpectAdvertisedWindow{50000});
+            test.execute(SegmentArrives{}
+                             .with_seqno(isn + 1)
+                             .with_data(string(99999, 'x'))
+                             .with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectWindow{1});
+            test.execute(ExpectAdvertisedWindow{0});
+        }
+
+        {
+            // a window scale option above 14 is treated as 14
+            size_t cap = 65535;
+            uint32_t isn = 5;
+            TCPReceiverTestHarness test{cap};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_window_scale(20).with_result(
+                SegmentArrives::Result::OK));
+            test.execute(ExpectWindowScale{0, 14});
+            test.execute(ExpectAdvertisedWindow{65535});
+        }
+
+        {
+            // segments before the SYN don't negotiate anything
+            size_t cap = 1 << 20;
+            TCPReceiverTestHarness test{cap};
+            test.execute(SegmentArrives{}.with_seqno(3).with_window_scale(3).with_result(
+                SegmentArrives::Result::NOT_SYN));
+            test.execute(ExpectWindowScale{5, {}});
+            test.execute(ExpectAdvertisedWindow{65535});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,75 @@
+#include "byte_stream.hh"
+#include "stream_reassembler.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t CAPACITY = 64000;  // not a power of two, so the two paths differ
+
+double byte_stream_gbps(const bool power_of_two_storage, const size_t chunk, const size_t total) {
+    ByteStream stream{CAPACITY, power_of_two_storage};
+    const string data(chunk, 'x');
+    size_t moved = 0;
+
+    const auto begin = chrono::steady_clock::now();
+    while (moved < total) {
+        stream.write(data);
+        moved += stream.read(chunk).size();
+    }
+    const auto end = chrono::steady_clock::now();
+
+    return double(moved) / chrono::duration<double>(end - begin).count() / 1e9;
+}
+
+// deliver segments in swapped pairs, so that every other segment waits in the window
+double reassembler_gbps(const bool power_of_two_storage, const size_t segment, const size_t total) {
+    StreamReassembler reassembler{CAPACITY, power_of_two_storage};
+    const string data(segment, 'x');
+    uint64_t index = 0;
+
+    const auto begin = chrono::steady_clock::now();
+    while (index < total) {
+        reassembler.push_substring(data, index + segment, false);
+        reassembler.push_substring(data, index, false);
+        index += 2 * segment;
+        reassembler.stream_out().pop_output(2 * segment);
+    }
+    const auto end = chrono::steady_clock::now();
+
+    if (reassembler.stream_out().bytes_written() != index) {
+        throw runtime_error("ring_index_benchmark: reassembler lost bytes");
+    }
+    return double(index) / chrono::duration<double>(end - begin).count() / 1e9;
+}
+
+int main() {
+    try {
+        cout << fixed << setprecision(3);
+        cout << setw(24) << "workload" << setw(14) << "modulo GB/s" << setw(14) << "mask GB/s"
+             << "\n";
+
+        for (const size_t chunk : {16, 256, 1460}) {
+            const size_t total = 64 * 1024 * 1024;
+            cout << setw(24) << ("ByteStream, " + to_string(chunk) + "B") << setw(14)
+                 << byte_stream_gbps(false, chunk, total) << setw(14) << byte_stream_gbps(true, chunk, total) << "\n";
+        }
+
+        for (const size_t segment : {256, 1460}) {
+            const size_t total = 16 * 1024 * 1024;
+            cout << setw(24) << ("StreamReassembler, " + to_string(segment) + "B") << setw(14)
+                 << reassembler_gbps(false, segment, total) << setw(14) << reassembler_gbps(true, segment, total)
+                 << "\n";
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,76 @@
+#include "byte_stream.hh"
+#include "page_pool.hh"
+#include "stream_reassembler.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t STREAMS = 100000;
+static constexpr size_t CAPACITY = 64000;
+static constexpr size_t SEGMENT = 1460;
+
+// Each stream is created, carries a few segments, and is destroyed, as for a short-lived connection
+double byte_stream_ns(Allocator &allocator) {
+    const string data(SEGMENT, 'x');
+
+    const auto begin = chrono::steady_clock::now();
+    for (size_t i = 0; i < STREAMS; ++i) {
+        ByteStream stream{CAPACITY, false, allocator};
+        stream.write(data);
+        stream.write(data);
+        if (stream.read(2 * SEGMENT).size() != 2 * SEGMENT) {
+            throw runtime_error("stream_churn_benchmark: stream lost bytes");
+        }
+    }
+    const auto end = chrono::steady_clock::now();
+
+    return chrono::duration<double, nano>(end - begin).count() / double(STREAMS);
+}
+
+// As above, but the second segment arrives before the first, so the reassembler also takes a page
+double reassembler_ns(Allocator &allocator) {
+    const string data(SEGMENT, 'x');
+
+    const auto begin = chrono::steady_clock::now();
+    for (size_t i = 0; i < STREAMS; ++i) {
+        StreamReassembler reassembler{CAPACITY, false, StreamReassembler::Backend::Intervals, allocator};
+        reassembler.push_substring(data, SEGMENT, false);
+        reassembler.push_substring(data, 0, false);
+        if (reassembler.stream_out().read(2 * SEGMENT).size() != 2 * SEGMENT) {
+            throw runtime_error("stream_churn_benchmark: reassembler lost bytes");
+        }
+    }
+    const auto end = chrono::steady_clock::now();
+
+    return chrono::duration<double, nano>(end - begin).count() / double(STREAMS);
+}
+
+int main() {
+    try {
+        PagePool &pool = PagePool::local();
+
+        cout << fixed << setprecision(1);
+        cout << "creating and destroying " << STREAMS << " streams of " << CAPACITY << " bytes\n";
+        cout << setw(20) << "workload" << setw(16) << "heap ns/stream" << setw(16) << "pool ns/stream"
+             << "\n";
+        cout << setw(20) << "ByteStream" << setw(16) << byte_stream_ns(HeapAllocator::instance()) << setw(16)
+             << byte_stream_ns(pool) << "\n";
+        cout << setw(20) << "StreamReassembler" << setw(16) << reassembler_ns(HeapAllocator::instance())
+             << setw(16) << reassembler_ns(pool) << "\n";
+
+        const PagePool::Stats &stats = pool.stats();
+        cout << "pool: " << stats.pages_in_use << " pages in use, high-water mark " << stats.high_water_mark
+             << " pages, " << stats.free_pages << " free pages, " << stats.heap_pages << " pages from the heap\n";
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,94 @@
+#include "stream_reassembler.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t SEGMENT = 1460;
+
+// Each round fills a whole window with every other segment, then fills the holes in order,
+// so every second push assembles two segments out of a window that is half full.
+double nanoseconds_per_segment(const size_t window, const StreamReassembler::Backend backend) {
+    StreamReassembler reassembler{window, false, backend};
+    const string data(SEGMENT, 'x');
+    const size_t segments_per_round = window / SEGMENT;
+    const size_t rounds = max(size_t(1), (size_t(64) << 20) / window);
+    uint64_t base = 0;
+    size_t pushes = 0;
+
+    const auto begin = chrono::steady_clock::now();
+    for (size_t round = 0; round < rounds; ++round) {
+        for (size_t i = 1; i < segments_per_round; i += 2, ++pushes) {
+            reassembler.push_substring(data, base + i * SEGMENT, false);
+        }
+        for (size_t i = 0; i < segments_per_round; i += 2, ++pushes) {
+            reassembler.push_substring(data, base + i * SEGMENT, false);
+            reassembler.stream_out().pop_output(reassembler.stream_out().buffer_size());
+        }
+        base += segments_per_round * SEGMENT;
+    }
+    const auto end = chrono::steady_clock::now();
+
+    if (reassembler.stream_out().bytes_written() != base or not reassembler.empty()) {
+        throw runtime_error("stream_reassembler_benchmark: reassembler lost bytes");
+    }
+    return chrono::duration<double, nano>(end - begin).count() / double(pushes);
+}
+
+// Segments arrive in order except that every eighth pair is swapped, as after a light reordering
+// on the path. Only a couple of segments are ever buffered, so the cost per segment must not
+// depend on the window size.
+double nanoseconds_per_segment_in_order(const size_t window, const StreamReassembler::Backend backend) {
+    StreamReassembler reassembler{window, false, backend};
+    const string data(SEGMENT, 'x');
+    const size_t segments = (size_t(64) << 20) / SEGMENT / 8 * 8;
+
+    const auto begin = chrono::steady_clock::now();
+    for (size_t i = 0; i < segments; i += 8) {
+        reassembler.push_substring(data, (i + 1) * SEGMENT, false);
+        reassembler.push_substring(data, i * SEGMENT, false);
+        for (size_t j = i + 2; j < i + 8; ++j) {
+            reassembler.push_substring(data, j * SEGMENT, j + 1 == segments);
+        }
+        reassembler.stream_out().pop_output(reassembler.stream_out().buffer_size());
+    }
+    const auto end = chrono::steady_clock::now();
+
+    if (reassembler.stream_out().bytes_written() != segments * SEGMENT or not reassembler.stream_out().eof()) {
+        throw runtime_error("stream_reassembler_benchmark: reassembler lost bytes");
+    }
+    return chrono::duration<double, nano>(end - begin).count() / double(segments);
+}
+
+int main() {
+    try {
+        cout << fixed << setprecision(1);
+        cout << setw(10) << "window" << setw(20) << "intervals ns/seg" << setw(18) << "bitmap ns/seg"
+             << "\n";
+        for (const size_t window : {4 << 10, 64 << 10, 1 << 20, 16 << 20}) {
+            cout << setw(9) << (window >> 10) << "K" << setw(20)
+                 << nanoseconds_per_segment(window, StreamReassembler::Backend::Intervals) << setw(18)
+                 << nanoseconds_per_segment(window, StreamReassembler::Backend::Bitmap) << "\n";
+        }
+
+        cout << "\nin order, every eighth pair swapped\n";
+        cout << setw(10) << "window" << setw(20) << "intervals ns/seg" << setw(18) << "bitmap ns/seg"
+             << "\n";
+        for (const size_t window : {16 << 10, 64 << 10, 1 << 20, 16 << 20}) {
+            cout << setw(9) << (window >> 10) << "K" << setw(20)
+                 << nanoseconds_per_segment_in_order(window, StreamReassembler::Backend::Intervals) << setw(18)
+                 << nanoseconds_per_segment_in_order(window, StreamReassembler::Backend::Bitmap) << "\n";
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
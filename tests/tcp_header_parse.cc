@@ -0,0 +1,56 @@
+#include "parser.hh"
+#include "tcp_header.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // TCPHeader::parse() must agree with parse_fields() on every input, including short and bad ones
+        for (unsigned int i = 0; i < 100000; i++) {
+            string data(uniform_int_distribution<size_t>{0, 72}(rd), 0);
+            generate(data.begin(), data.end(), [&] { return char(rd()); });
+            if (data.size() > 12 and rd() % 2) {
+                data[12] = char((5 + rd() % 4) << 4);  // mostly plausible data offsets
+            }
+
+            NetParser fast_parser{string(data)};
+            NetParser slow_parser{string(data)};
+            if (rd() % 16 == 0) {
+                fast_parser.set_error(ParseResult::TruncatedPacket);
+                slow_parser.set_error(ParseResult::TruncatedPacket);
+            }
+
+            TCPHeader fast, slow;
+            const ParseResult fast_result = fast.parse(fast_parser);
+            const ParseResult slow_result = slow.parse_fields(slow_parser);
+
+            if (fast_result != slow_result or fast_parser.get_error() != slow_parser.get_error()) {
+                throw runtime_error("parse() returned " + as_string(fast_result) + " but parse_fields() returned " +
+                                    as_string(slow_result) + " for " + to_string(data.size()) + " bytes");
+            }
+            if (fast.to_string() != slow.to_string()) {
+                throw runtime_error("parse() and parse_fields() decoded different headers:\n" + fast.to_string() +
+                                    "\n" + slow.to_string());
+            }
+            if (fast_parser.unparsed().size() != slow_parser.unparsed().size()) {
+                throw runtime_error("parse() and parse_fields() consumed different numbers of bytes");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
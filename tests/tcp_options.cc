@@ -0,0 +1,108 @@
+#include "tcp_header.hh"
+#include "tcp_options.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+void check(const bool condition, const string &what) {
+    if (not condition) {
+        throw runtime_error(what);
+    }
+}
+
+int main() {
+    try {
+        // the options from a typical Linux SYN: MSS, SACK-permitted, timestamps, NOP and window scale
+        {
+            TCPOptions options;
+            options.parse(string("\x02\x04\x05\xb4\x04\x02\x08\x0a\x00\x01\x02\x03"
+                                 "\x00\x00\x00\x00\x01\x03\x03\x07",
+                                 20));
+            check(options.mss == 1460, "wrong MSS");
+            check(options.sack_permitted, "missing SACK-permitted");
+            check(options.timestamps and options.timestamps->value == 0x010203 and options.timestamps->echo_reply == 0,
+                  "wrong timestamps");
+            check(options.window_scale == 7, "wrong window scale");
+            check(options.sack_block_count == 0, "unexpected SACK blocks");
+        }
+
+        // SACK blocks, after an option that isn't understood
+        {
+            TCPOptions options;
+            options.parse(string("\x1e\x04\xff\xff\x05\x12\x00\x00\x00\x01\x00\x00\x00\x02"
+                                 "\x00\x00\x00\x05\x00\x00\x00\x09",
+                                 22));
+            check(options.sack_block_count == 2, "wrong number of SACK blocks");
+            check(options.sack_blocks[0].begin == WrappingInt32{1} and options.sack_blocks[0].end == WrappingInt32{2},
+                  "wrong first SACK block");
+            check(options.sack_blocks[1].begin == WrappingInt32{5} and options.sack_blocks[1].end == WrappingInt32{9},
+                  "wrong second SACK block");
+        }
+
+        // malformed options: a bad length ends parsing, a wrong-sized option is skipped
+        {
+            TCPOptions options;
+            options.parse(string("\x02\x03\x05\x03\x03\x07\x02\x00\x04\x02", 10));
+            check(not options.mss, "accepted an MSS with the wrong length");
+            check(options.window_scale == 7, "missed the window scale");
+            check(not options.sack_permitted, "kept parsing after an option with a bad length");
+
+            options.parse(string("\x04\x02\x08\x0a\x00\x00", 6));
+            check(options.sack_permitted and not options.timestamps, "mishandled a truncated option");
+
+            options.parse(string("\x03\x03\x02\x00\x02\x04\x05\xb4", 8));
+            check(options.window_scale == 2 and not options.mss, "kept parsing after the end of the options");
+        }
+
+        // random options survive a round trip through a serialized segment
+        auto rd = get_random_generator();
+        for (unsigned int i = 0; i < 10000; i++) {
+            TCPSegment segment;
+            TCPHeader &header = segment.header();
+            header.seqno = WrappingInt32{uint32_t(rd())};
+            header.win = rd();
+            header.doff = 5 + rd() % 2;
+
+            TCPOptions &options = header.options;
+            if (rd() % 2) {
+                options.mss = uint16_t(rd());
+            }
+            if (rd() % 2) {
+                options.window_scale = uint8_t(rd() % 15);
+            }
+            options.sack_permitted = rd() % 2;
+            if (rd() % 2) {
+                options.timestamps = TCPOptions::Timestamps{uint32_t(rd()), uint32_t(rd())};
+            }
+            while (options.sack_block_count < TCPOptions::MAX_SACK_BLOCKS and options.length() + 12 <= 40 and
+                   rd() % 2) {
+                options.sack_blocks[options.sack_block_count++] = {WrappingInt32{uint32_t(rd())},
+                                                                   WrappingInt32{uint32_t(rd())}};
+            }
+            segment.payload() = string(rd() % 100, 'x');
+
+            const string serialized = segment.serialize().concatenate();
+            check(serialized.size() == header.length() + segment.payload().size(), "wrong serialized length");
+
+            TCPSegment parsed;
+            check(parsed.parse(string(serialized)) == ParseResult::NoError, "serialized segment doesn't parse");
+            check(parsed.header().options == options, "options changed in a round trip:\n" + options.to_string() +
+                                                          "\n" + parsed.header().options.to_string());
+            check(size_t(4 * parsed.header().doff) == header.length(), "data offset doesn't cover the options");
+            check(parsed.payload().str() == segment.payload().str(), "payload changed in a round trip");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -5,12 +5,14 @@
 #include "util.hh"
 
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <cstdlib>
 #include <exception>
 #include <iostream>
 #include <pcap/pcap.h>
 #include <string>
+#include <string_view>
 #include <vector>
 
 using namespace std;
@@ -23,6 +25,28 @@ uint16_t inet_cksum(const uint8_t *data, const size_t len) {
     return check.value();
 }
 
+// Parse every captured segment's header over and over with `parse`, and return headers/sec.
+template <typename ParseMethod>
+double headers_per_second(const vector<Buffer> &segments, const ParseMethod parse) {
+    const size_t repetitions = max(size_t(1), size_t(1 << 24) / segments.size());
+    size_t parsed = 0;
+    TCPHeader header;
+
+    const auto begin = chrono::steady_clock::now();
+    for (size_t i = 0; i < repetitions; ++i) {
+        for (const auto &segment : segments) {
+            NetParser p{segment};
+            parsed += (header.*parse)(p) == ParseResult::NoError;
+        }
+    }
+    const auto end = chrono::steady_clock::now();
+
+    if (parsed != repetitions * segments.size()) {
+        throw runtime_error("header parse failed during benchmark");
+    }
+    return double(parsed) / chrono::duration<double>(end - begin).count();
+}
+
 int main(int argc, char **argv) {
     try {
         // first, make sure the parser gets the correct values and catches errors
@@ -120,7 +144,7 @@ int main(int argc, char **argv) {
 
         // now process some segments off the wire for correctness of parser and unparser
         if (argc < 2) {
-            cout << "USAGE: " << argv[0] << " <filename>" << endl;
+            cout << "USAGE: " << argv[0] << " <filename> [--benchmark]" << endl;
             return EXIT_FAILURE;
         }
 
@@ -137,6 +161,7 @@ int main(int argc, char **argv) {
         }
 
         bool ok = true;
+        vector<Buffer> captured_segments;
         const uint8_t *pkt;
         struct pcap_pkthdr hdr;
         while ((pkt = pcap_next(pcap, &hdr)) != nullptr) {
@@ -172,6 +197,7 @@ int main(int argc, char **argv) {
                 tcp_data[16] = cksum_fixup >> 8;
                 tcp_data[17] = cksum_fixup & 0xff;
 
+                captured_segments.emplace_back(string(tcp_data.begin(), tcp_data.end()));
                 TCPSegment tcp_seg_ret;
                 const auto parse_result = tcp_seg_ret.parse(string(tcp_data.begin(), tcp_data.end()), 0);
                 return make_tuple(tcp_seg_ret, parse_result);
@@ -198,6 +224,7 @@ int main(int argc, char **argv) {
                 tcp_hdr_copy = tcp_hdr_orig;
                 // fix up segment to remove IPv4 and TCP header extensions
                 tcp_hdr_copy.doff = 5;
+                tcp_hdr_copy.options = {};
             }  // tcp_hdr_{orig,copy} go out of scope
 
             if (!compare_tcp_headers_nolen(tcp_seg.header(), tcp_seg_copy.header())) {
@@ -236,6 +263,14 @@ int main(int argc, char **argv) {
         if (!ok) {
             return EXIT_FAILURE;
         }
+
+        // optionally, measure header parsing throughput on the captured segments
+        if (argc > 2 and string_view(argv[2]) == "--benchmark" and not captured_segments.empty()) {
+            cout << "parse:        " << headers_per_second(captured_segments, &TCPHeader::parse) / 1e6
+                 << " M headers/sec\n";
+            cout << "parse_fields: " << headers_per_second(captured_segments, &TCPHeader::parse_fields) / 1e6
+                 << " M headers/sec\n";
+        }
     } catch (const exception &e) {
         cout << "Exception: " << e.what() << endl;
         return EXIT_FAILURE;
@@ -0,0 +1,67 @@
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        for (unsigned int i = 0; i < 10000; i++) {
+            TCPSegment segment;
+            TCPHeader &header = segment.header();
+            header.sport = rd();
+            header.dport = rd();
+            header.seqno = WrappingInt32{uint32_t(rd())};
+            header.ackno = WrappingInt32{uint32_t(rd())};
+            header.doff = 5 + rd() % 3;
+            header.ack = rd() % 2;
+            header.syn = rd() % 2;
+            header.fin = rd() % 2;
+            header.win = rd();
+            header.uptr = rd();
+
+            string payload(uniform_int_distribution<size_t>{0, 1501}(rd), 0);
+            generate(payload.begin(), payload.end(), [&] { return char(rd()); });
+            segment.payload() = Buffer{move(payload)};
+
+            const uint32_t pseudo_checksum = rd() % 2 ? 0 : rd();
+            const BufferList serialized = segment.serialize(pseudo_checksum);
+
+            header.seqno = WrappingInt32{uint32_t(rd())};
+            header.ackno = WrappingInt32{uint32_t(rd())};
+            header.win = rd() % 4 ? uint16_t(rd()) : header.win;
+
+            // rewriting the serialized segment gives the same bytes as serializing the changed segment
+            const BufferList rewritten = TCPSegment::rewrite(serialized, header.seqno, header.ackno, header.win);
+            if (rewritten.concatenate() != segment.serialize(pseudo_checksum).concatenate()) {
+                throw runtime_error("rewritten segment differs from a freshly serialized one");
+            }
+
+            // ... and the payload is shared, not copied
+            if (segment.payload().size() and
+                rewritten.buffers().back().str().data() != serialized.buffers().back().str().data()) {
+                throw runtime_error("rewritten segment copied the payload");
+            }
+
+            TCPSegment parsed;
+            if (parsed.parse(rewritten.concatenate(), pseudo_checksum) != ParseResult::NoError or
+                not(parsed.header() == header)) {
+                throw runtime_error("rewritten segment doesn't parse back to the changed header");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+// count heap allocations, to check that serialize_into() doesn't make any
+static size_t allocations = 0;
+
+void *operator new(size_t size) {
+    ++allocations;
+    if (void *ptr = malloc(size)) {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        array<char, 64> packet{};
+
+        for (unsigned int i = 0; i < 10000; i++) {
+            TCPSegment segment;
+            TCPHeader &header = segment.header();
+            header.sport = rd();
+            header.dport = rd();
+            header.seqno = WrappingInt32{uint32_t(rd())};
+            header.ackno = WrappingInt32{uint32_t(rd())};
+            header.doff = 5 + rd() % 3;
+            header.ack = rd() % 2;
+            header.psh = rd() % 2;
+            header.syn = rd() % 2;
+            header.fin = rd() % 2;
+            header.win = rd();
+            header.cksum = rd();
+            header.uptr = rd();
+
+            string payload(uniform_int_distribution<size_t>{0, 1501}(rd), 0);
+            generate(payload.begin(), payload.end(), [&] { return char(rd()); });
+            segment.payload() = Buffer{move(payload)};
+            const uint32_t pseudo_checksum = rd() % 2 ? 0 : rd();
+
+            const size_t allocations_before = allocations;
+            const array<iovec, 2> iovecs = segment.serialize_into(packet.data(), packet.size(), pseudo_checksum);
+            if (allocations != allocations_before) {
+                throw runtime_error("serialize_into() allocated memory");
+            }
+
+            // the iovecs hold the same bytes as serialize(), with the payload in place
+            const string written = string(static_cast<const char *>(iovecs[0].iov_base), iovecs[0].iov_len) +
+                                   string(static_cast<const char *>(iovecs[1].iov_base), iovecs[1].iov_len);
+            if (written != segment.serialize(pseudo_checksum).concatenate()) {
+                throw runtime_error("serialize_into() differs from serialize()");
+            }
+            if (iovecs[0].iov_base != packet.data() or iovecs[1].iov_base != segment.payload().str().data()) {
+                throw runtime_error("serialize_into() didn't write in place");
+            }
+        }
+
+        // the header has to fit in the caller's memory
+        TCPSegment segment;
+        bool threw = false;
+        try {
+            segment.serialize_into(packet.data(), TCPHeader::LENGTH - 1);
+        } catch (const runtime_error &) {
+            threw = true;
+        }
+        if (not threw) {
+            throw runtime_error("serialize_into() overran a buffer that was too small for the header");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
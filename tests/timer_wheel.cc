@@ -0,0 +1,131 @@
+#include "timer_wheel.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static void check(const bool condition, const string &message) {
+    if (not condition) {
+        throw runtime_error(message);
+    }
+}
+
+// A random mix of adds (some from inside callbacks), cancels and advances, short and long,
+// checked against the obvious implementation: every pending timer fires at the first advance
+// that reaches its deadline, exactly once and in order of deadline.
+static void check_against_reference(mt19937 &rd, const uint64_t start) {
+    TimerWheel wheel{start};
+    uint64_t now = start;  // the wheel has run every millisecond before this one
+
+    map<size_t, uint64_t> pending{};  // timer number -> deadline
+    vector<TimerWheel::Handle> handles{};
+    vector<pair<size_t, uint64_t>> fired{};
+
+    const auto random_delay = [&]() -> uint64_t {
+        switch (rd() % 5) {
+            case 0:
+                return rd() % 64;
+            case 1:
+                return rd() % 5000;
+            case 2:
+                return rd() % (1 << 20);
+            case 3:
+                return rd() % (uint64_t(1) << 27);  // beyond the top level
+            default:
+                return 0;
+        }
+    };
+
+    function<void(uint64_t, bool)> add = [&](const uint64_t deadline, const bool chain) {
+        const size_t number = handles.size();
+        const uint64_t effective = max(deadline, now);
+        pending[number] = effective;
+        handles.push_back(wheel.add(deadline, [&, number, effective, chain] {
+            fired.emplace_back(number, effective);
+            if (chain) {
+                add(now + rd() % 200, false);  // `now` is already past the deadline being run
+            }
+        }));
+    };
+
+    for (unsigned round = 0; round < 2000; ++round) {
+        for (unsigned i = rd() % 8; i > 0; --i) {
+            // a few deadlines lie in the past
+            const uint64_t base = rd() % 10 == 0 ? now - min(now, uint64_t(rd() % 100)) : now;
+            add(base + random_delay(), rd() % 4 == 0);
+        }
+
+        for (unsigned i = rd() % 3; i > 0 and not handles.empty(); --i) {
+            const size_t number = rd() % handles.size();
+            const bool was_pending = pending.erase(number);
+            check(wheel.cancel(handles[number]) == was_pending, "cancel() disagreed about a timer being pending");
+        }
+
+        check(wheel.size() == pending.size(), "size() disagreed with the reference");
+        if (not pending.empty()) {
+            uint64_t earliest = UINT64_MAX;
+            for (const auto &[number, deadline] : pending) {
+                earliest = min(earliest, deadline);
+            }
+            const auto next = wheel.next_deadline();
+            check(next.has_value() and *next <= earliest and *next >= now, "next_deadline() is out of bounds");
+        } else {
+            check(not wheel.next_deadline().has_value(), "next_deadline() of an empty wheel");
+        }
+
+        // mostly small steps, with the occasional jump of hours
+        const uint64_t step = rd() % 20 == 0 ? rd() % (uint64_t(1) << 26) : rd() % 300;
+        const uint64_t until = now + step;
+        fired.clear();
+        now = until + 1;  // set before advancing, so chained timers see the wheel's time
+        wheel.advance(until);
+
+        uint64_t previous = 0;
+        for (const auto &[number, deadline] : fired) {
+            check(deadline <= until, "a timer ran before its deadline");
+            check(deadline >= previous, "timers ran out of order");
+            check(pending.erase(number) == 1, "a timer ran that was not pending");
+            previous = deadline;
+        }
+        for (const auto &[number, deadline] : pending) {
+            check(deadline > until, "timer " + to_string(number) + " did not run at its deadline");
+        }
+    }
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        for (unsigned i = 0; i < 20; ++i) {
+            // start anywhere, including just before a wrap of the top level
+            const uint64_t start = i % 2 ? rd() : (uint64_t(rd() % 8 + 1) << 24) - rd() % 100;
+            check_against_reference(rd, start);
+        }
+
+        // a handle stays safe to cancel after its timer has run and its entry has been reused
+        {
+            TimerWheel wheel{};
+            unsigned runs = 0;
+            const auto first = wheel.add(5, [&] { ++runs; });
+            check(wheel.advance(5) == 1 and runs == 1, "timer did not run at its deadline");
+            const auto second = wheel.add(10, [&] { ++runs; });
+            check(not wheel.cancel(first), "a stale handle canceled a timer");
+            check(wheel.advance(10) == 1 and runs == 2, "reused entry did not run");
+            check(not wheel.cancel(second), "an expired timer was canceled");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
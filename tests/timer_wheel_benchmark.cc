@@ -0,0 +1,106 @@
+#include "timer_wheel.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t TIMERS = 1 << 20;
+static constexpr uint64_t SPREAD_MS = 60000;  // deadlines up to a minute away, like retransmission timers
+
+// The obvious alternative: an ordered multimap of deadlines, canceled through saved iterators
+class MultimapTimers {
+    multimap<uint64_t, function<void(void)>> _timers{};
+
+  public:
+    using Handle = multimap<uint64_t, function<void(void)>>::iterator;
+
+    Handle add(const uint64_t deadline, const function<void(void)> &callback) {
+        return _timers.emplace(deadline, callback);
+    }
+    void cancel(const Handle handle) { _timers.erase(handle); }
+    size_t advance(const uint64_t now) {
+        size_t expired = 0;
+        while (not _timers.empty() and _timers.begin()->first <= now) {
+            const auto callback = move(_timers.begin()->second);
+            _timers.erase(_timers.begin());
+            callback();
+            ++expired;
+        }
+        return expired;
+    }
+};
+
+template <typename Timers>
+void run(const char *name, const vector<uint64_t> &deadlines, const vector<size_t> &cancel_order) {
+    Timers timers{};
+    vector<typename Timers::Handle> handles(deadlines.size());
+    size_t runs = 0;
+
+    // arm every timer, then cancel them all in a random order
+    const auto begin = chrono::steady_clock::now();
+    for (size_t i = 0; i < deadlines.size(); ++i) {
+        handles[i] = timers.add(deadlines[i], [&runs] { ++runs; });
+    }
+    const auto armed = chrono::steady_clock::now();
+    for (const size_t i : cancel_order) {
+        timers.cancel(handles[i]);
+    }
+    const auto canceled = chrono::steady_clock::now();
+
+    // arm them again and let them all expire, a millisecond at a time
+    for (size_t i = 0; i < deadlines.size(); ++i) {
+        timers.add(deadlines[i], [&runs] { ++runs; });
+    }
+    const auto rearmed = chrono::steady_clock::now();
+    for (uint64_t now = 0; now <= SPREAD_MS; ++now) {
+        timers.advance(now);
+    }
+    const auto end = chrono::steady_clock::now();
+
+    if (runs != deadlines.size()) {
+        throw runtime_error("timer_wheel_benchmark: timers were lost");
+    }
+
+    const auto ns_per_timer = [&](const auto from, const auto to) {
+        return chrono::duration<double, nano>(to - from).count() / double(deadlines.size());
+    };
+    cout << setw(10) << name << setw(12) << ns_per_timer(begin, armed) << setw(12) << ns_per_timer(armed, canceled)
+         << setw(12) << ns_per_timer(rearmed, end) << "\n";
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        vector<uint64_t> deadlines(TIMERS);
+        for (auto &deadline : deadlines) {
+            deadline = 1 + rd() % SPREAD_MS;
+        }
+        vector<size_t> cancel_order(TIMERS);
+        for (size_t i = 0; i < TIMERS; ++i) {
+            cancel_order[i] = i;
+        }
+        shuffle(cancel_order.begin(), cancel_order.end(), rd);
+
+        cout << fixed << setprecision(1);
+        cout << TIMERS << " timers, deadlines up to " << SPREAD_MS << " ms away\n";
+        cout << setw(10) << "" << setw(12) << "ns/add" << setw(12) << "ns/cancel" << setw(12) << "ns/expiry"
+             << "\n";
+        run<TimerWheel>("wheel", deadlines, cancel_order);
+        run<MultimapTimers>("multimap", deadlines, cancel_order);
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
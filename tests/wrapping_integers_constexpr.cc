@@ -0,0 +1,47 @@
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+
+// Sequence-number arithmetic is constexpr, so these vectors are checked when the test compiles.
+
+constexpr uint64_t TWO_32 = uint64_t(1) << 32;
+
+// wrap() keeps the lower 32 bits of the ISN plus the ASN
+static_assert(wrap(0, WrappingInt32{0}) == WrappingInt32{0});
+static_assert(wrap(3 * TWO_32 + 17, WrappingInt32{15}) == WrappingInt32{32});
+static_assert(wrap(1, WrappingInt32{UINT32_MAX}) == WrappingInt32{0});
+static_assert(wrap(UINT64_MAX, WrappingInt32{1}) == WrappingInt32{0});
+
+// wraparound at 2^32
+static_assert(unwrap(WrappingInt32{0}, WrappingInt32{0}, UINT32_MAX) == TWO_32);
+static_assert(unwrap(WrappingInt32{UINT32_MAX}, WrappingInt32{0}, TWO_32) == UINT32_MAX);
+static_assert(unwrap(WrappingInt32{1}, WrappingInt32{UINT32_MAX}, TWO_32 - 1) == TWO_32 + 2);
+static_assert(unwrap(WrappingInt32{UINT32_MAX - 1}, WrappingInt32{0}, 3 * TWO_32) == 3 * TWO_32 - 2);
+
+// checkpoint near 0: there is no ASN below 0, however close it would be
+static_assert(unwrap(WrappingInt32{UINT32_MAX}, WrappingInt32{0}, 0) == UINT32_MAX);
+static_assert(unwrap(WrappingInt32{15}, WrappingInt32{16}, 0) == UINT32_MAX);
+static_assert(unwrap(WrappingInt32{0}, WrappingInt32{INT32_MAX}, 0) == uint64_t(INT32_MAX) + 2);
+static_assert(unwrap(WrappingInt32{16}, WrappingInt32{16}, 0) == 0);
+static_assert(unwrap(WrappingInt32{UINT32_MAX}, WrappingInt32{0}, 1) == UINT32_MAX);
+
+// checkpoint near 2^64: there is no ASN above 2^64 - 1, however close it would be
+static_assert(unwrap(WrappingInt32{0}, WrappingInt32{0}, UINT64_MAX) == UINT64_MAX - UINT32_MAX);
+static_assert(unwrap(WrappingInt32{UINT32_MAX}, WrappingInt32{0}, UINT64_MAX) == UINT64_MAX);
+static_assert(unwrap(WrappingInt32{0}, WrappingInt32{0}, UINT64_MAX - 10) == UINT64_MAX - UINT32_MAX);
+static_assert(unwrap(wrap(UINT64_MAX - 5, WrappingInt32{9}), WrappingInt32{9}, UINT64_MAX) == UINT64_MAX - 5);
+
+// a tie (2^31 either way) keeps the upper 32 bits of the checkpoint
+static_assert(unwrap(WrappingInt32{1u << 31}, WrappingInt32{0}, TWO_32) == TWO_32 + (1u << 31));
+static_assert(unwrap(WrappingInt32{0}, WrappingInt32{0}, TWO_32 + (1u << 31)) == TWO_32);
+static_assert(unwrap(WrappingInt32{(1u << 31) + 1}, WrappingInt32{0}, TWO_32) == (1u << 31) + 1);
+
+// the helper operators
+static_assert(WrappingInt32{5} - WrappingInt32{UINT32_MAX} == 6);
+static_assert(WrappingInt32{UINT32_MAX} - WrappingInt32{5} == -6);
+static_assert(WrappingInt32{UINT32_MAX} + 2 == WrappingInt32{1});
+static_assert(WrappingInt32{1} - 2u == WrappingInt32{UINT32_MAX});
+static_assert(WrappingInt32{1} != WrappingInt32{2});
+
+int main() { return EXIT_SUCCESS; }
@@ -0,0 +1,114 @@
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+// The original unwrap(), which picks the closest of three candidate ASNs with comparisons
+static uint64_t reference_unwrap(WrappingInt32 sn, WrappingInt32 isn, uint64_t checkpoint) {
+    uint64_t mask_l32 = (1ul << 32) - 1;
+    uint64_t mask_u32 = ~mask_l32;
+
+    uint32_t asn_l32 = sn.raw_value() - isn.raw_value();
+    uint32_t checkpoint_l32 = uint32_t(checkpoint & mask_l32);
+    uint64_t checkpoint_u32 = checkpoint & mask_u32;
+
+    uint64_t asn_left = checkpoint_u32 - (1ul << 32) + uint64_t(asn_l32);
+    uint64_t asn_mid = checkpoint_u32 + uint64_t(asn_l32);
+    uint64_t asn_right = checkpoint_u32 + (1ul << 32) + uint64_t(asn_l32);
+
+    uint64_t diff_left = checkpoint - asn_left;
+    uint64_t diff_right = asn_right - checkpoint;
+    uint64_t diff_mid = checkpoint_l32 >= asn_l32 ? checkpoint - asn_mid : asn_mid - checkpoint;
+
+    uint64_t diff_min = diff_mid;
+    if (checkpoint_u32 > mask_l32)
+        diff_min = diff_min <= diff_left ? diff_min : diff_left;
+    if (checkpoint_u32 < mask_u32)
+        diff_min = diff_min <= diff_right ? diff_min : diff_right;
+
+    if (diff_min == diff_mid)
+        return asn_mid;
+    else if (diff_min == diff_left)
+        return asn_left;
+    else
+        return asn_right;
+}
+
+static void check(const WrappingInt32 sn, const WrappingInt32 isn, const uint64_t checkpoint) {
+    const uint64_t expected = reference_unwrap(sn, isn, checkpoint);
+    const uint64_t actual = unwrap(sn, isn, checkpoint);
+    if (actual != expected) {
+        ostringstream ss;
+        ss << "unwrap(" << sn << ", " << isn << ", " << checkpoint << ") returned " << actual << ", but " << expected
+           << " was expected";
+        throw runtime_error(ss.str());
+    }
+}
+
+int main() {
+    try {
+        // every pair of lower 32 bits near the points where the answer changes blocks (0, 2^31 and 2^32),
+        // with the checkpoint in the first, last and some middle blocks
+        vector<uint32_t> edges;
+        for (uint32_t i = 0; i < 256; i++) {
+            edges.push_back(i);
+            edges.push_back((1u << 31) - 256 + i);
+            edges.push_back((1u << 31) + i);
+            edges.push_back(UINT32_MAX - i);
+        }
+        for (const uint64_t upper : {0ul, 1ul, 2ul, 1ul << 31, 0xFFFFFFFEul, 0xFFFFFFFFul}) {
+            for (const uint32_t lower : edges) {
+                for (const uint32_t offset : edges) {
+                    check(WrappingInt32{offset}, WrappingInt32{0}, (upper << 32) | lower);
+                }
+            }
+        }
+
+        auto rd = get_random_generator();
+        uniform_int_distribution<uint32_t> dist32;
+        uniform_int_distribution<uint64_t> dist64;
+        uniform_int_distribution<size_t> edge(0, edges.size() - 1);
+
+        // random SNs, ISNs and checkpoints, anywhere and near the edges
+        for (size_t i = 0; i < 10'000'000; i++) {
+            const WrappingInt32 sn{dist32(rd)};
+            const WrappingInt32 isn{dist32(rd)};
+            check(sn, isn, dist64(rd));
+            check(sn, isn, (uint64_t(edges[edge(rd)]) << 32) | dist32(rd));
+            check(isn + edges[edge(rd)], isn, (uint64_t(dist32(rd)) << 32) | edges[edge(rd)]);
+        }
+
+        // unwrap_many() matches unwrap() element for element, at any alignment and length
+        vector<WrappingInt32> sns;
+        vector<uint64_t> asns(130);
+        for (size_t i = 0; i < 130; i++) {
+            sns.emplace_back(dist32(rd));
+        }
+        for (size_t round = 0; round < 10000; round++) {
+            const WrappingInt32 isn{dist32(rd)};
+            const uint64_t checkpoint = round % 2 ? dist64(rd) : (uint64_t(edges[edge(rd)]) << 32) | dist32(rd);
+            const size_t first = round % 3;
+            const size_t count = round % 128;
+            unwrap_many(sns.data() + first, asns.data() + first, count, isn, checkpoint);
+            for (size_t i = first; i < first + count; i++) {
+                if (asns[i] != unwrap(sns[i], isn, checkpoint)) {
+                    throw runtime_error("unwrap_many() disagreed with unwrap()");
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}